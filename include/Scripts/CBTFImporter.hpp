@@ -1,15 +1,24 @@
 #pragma once
 #include <SorghumLayer.hpp>
+#include <future>
 
 using namespace EcoSysLab;
 
 namespace Scripts {
 class CBTFImporter : public IPrivateComponent{
+  //Folder being imported and compressed in the background. The ray tracer facility makes no
+  //thread safety promise, so only one folder is processed at a time.
+  std::future<bool> m_task;
+  int m_totalFolders = 0;
+  int m_finishedFolders = 0;
+  int m_failedFolders = 0;
+  void CollectFinishedTask(bool wait);
 public:
   bool m_processing = false;
   std::filesystem::path m_currentExportFolder;
   std::vector<std::filesystem::path> m_importFolders;
   void OnInspect() override;
   void Update() override;
+  void OnDestroy() override;
 };
-}
\ No newline at end of file
+}
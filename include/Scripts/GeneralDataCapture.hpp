@@ -1,6 +1,7 @@
 #pragma once
 #include <AutoSorghumGenerationPipeline.hpp>
 #ifdef RAYTRACERFACILITY
+#include <AsyncOutputWriter.hpp>
 #include <SorghumLayer.hpp>
 
 #include "RayTracerCamera.hpp"
@@ -27,6 +28,12 @@ class GeneralDataCapture : public IAutoSorghumGenerationPipelineBehaviour {
   std::vector<glm::mat4> m_views;
   std::vector<std::string> m_names;
   void ExportMatrices(const std::filesystem::path& path);
+  //Per-sample matrices together with the shard list, replaces matrices.yml when packing.
+  void ExportManifest(const std::filesystem::path& path);
+  void EmitCaptureInfo(YAML::Emitter &out) const;
+  //Images and meshes are encoded and written in the background, flushed in OnEnd.
+  std::shared_ptr<AsyncOutputWriter> m_outputWriter;
+  std::shared_ptr<DatasetShardWriter> m_shardWriter;
 
 public:
   RayProperties m_rayProperties = {6, 256};
@@ -35,6 +42,13 @@ public:
   bool m_captureImage = true;
   bool m_captureMask = true;
   bool m_captureMesh = false;
+  //0: OBJ, 1: PLY, 2: GLB.
+  int m_meshFormat = 0;
+  int m_outputThreads = 2;
+  //Outputs are appended to a few large shard files with an index instead of one file each.
+  bool m_packShards = false;
+  //In megabytes.
+  int m_shardSize = 1024;
   bool m_captureDepth = true;
   bool m_exportMatrices = true;
   std::filesystem::path m_currentExportFolder;
@@ -3,18 +3,25 @@
 #include "GeneralAutomatedPipeline.hpp"
 #include "RayTracer.hpp"
 #include <SorghumLayer.hpp>
+#include "SkyIlluminance.hpp"
 using namespace EcoSysLab;
 using namespace RayTracerFacility;
 namespace Scripts {
 class IlluminationEstimationPipeline
     : public IGeneralAutomatedPipelineBehaviour {
   float m_currentTime = 0;
+  std::vector<SunDirectionBin> m_bins;
+  size_t m_currentBin = 0;
 
 public:
   std::filesystem::path m_currentExportFolder;
   Entity Instantiate() override;
   void ExportCSV(const std::filesystem::path &path);
   float m_timeInterval = 5;
+  //Traces once per sun direction bin of the window and weights by its energy,
+  //instead of once per time step. The result is a single row of integrated values.
+  bool m_binnedIntegration = false;
+  glm::vec2 m_integrationWindow = glm::vec2(0, 1440);
   RayProperties m_rayProperties = {8, 1000};
   AssetRef m_skyIlluminance;
   std::vector<AssetRef> m_sensorGroups;
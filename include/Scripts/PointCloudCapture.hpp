@@ -1,4 +1,5 @@
 #pragma once
+#include <AsyncOutputWriter.hpp>
 #include <AutoSorghumGenerationPipeline.hpp>
 #include <SorghumLayer.hpp>
 using namespace EcoSysLab;
@@ -14,6 +15,9 @@ namespace Scripts {
 		int m_segmentAmount = 3;
 
 		float m_positionVariance = 0.4f;
+		bool m_snapToGround = false;
+		//Single interleaved vertex element, float positions relative to a stored offset and narrow labels.
+		bool m_compactOutput = false;
 		void OnInspect();
 		void Serialize(const std::string& name, YAML::Emitter& out) const;
 		void Deserialize(const std::string& name, const YAML::Node& in);
@@ -23,8 +27,12 @@ namespace Scripts {
 		Entity m_ground;
 		glm::dvec2 m_currentCenter;
 		void Instantiate();
+		void SnapFieldToGround(const std::shared_ptr<Scene>& scene, float groundHeight) const;
+		//Point clouds and CSVs are written in the background, flushed in OnEnd.
+		std::shared_ptr<AsyncOutputWriter> m_outputWriter;
 	public:
 		PointCloudSampleSettings m_settings;
+		int m_outputThreads = 2;
 		void Reset(AutoSorghumGenerationPipeline& pipeline);
 		AssetRef m_positionsField;
 		AssetRef m_fieldGround;
@@ -44,6 +52,17 @@ namespace Scripts {
 			const std::filesystem::path& savePath,
 			const PointCloudSampleSettings& settings);
 
-		static void ExportCSV(AutoSorghumGenerationPipeline& pipeline, const std::filesystem::path& path);
+		static void ExportCSV(AutoSorghumGenerationPipeline& pipeline, const std::filesystem::path& path,
+			const std::shared_ptr<AsyncOutputWriter>& outputWriter = nullptr);
+		static bool WritePly(const std::filesystem::path& path,
+			std::vector<glm::dvec3>& points, std::vector<glm::vec3>& colors,
+			std::vector<int>& leafIndex, std::vector<int>& leafPartIndex,
+			std::vector<int>& isMainPlant, std::vector<int>& plantIndex,
+			std::vector<int>& isGround);
+		static bool WriteCompactPly(const std::filesystem::path& path,
+			const std::vector<glm::dvec3>& points, const std::vector<glm::vec3>& colors,
+			const std::vector<int>& leafIndex, const std::vector<int>& leafPartIndex,
+			const std::vector<int>& isMainPlant, const std::vector<int>& plantIndex,
+			const std::vector<int>& isGround);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include "DatasetShardWriter.hpp"
+#include <sorghum_factory_export.h>
+
+using namespace UniEngine;
+namespace EcoSysLab {
+//Encodes and writes pipeline outputs on worker threads. Producers hand over owned buffers and
+//continue, Submit only blocks while the queue is full. Flush waits for everything submitted so far.
+class SORGHUM_FACTORY_API AsyncOutputWriter {
+  std::mutex m_mutex;
+  std::condition_variable m_taskAvailable;
+  std::condition_variable m_slotAvailable;
+  std::condition_variable m_idle;
+  std::deque<std::function<bool()>> m_tasks;
+  std::vector<std::thread> m_workers;
+  size_t m_capacity = 64;
+  //Queued and running tasks.
+  size_t m_pending = 0;
+  int m_failed = 0;
+  bool m_stop = false;
+  std::shared_ptr<DatasetShardWriter> m_shardWriter;
+  std::filesystem::path m_shardRoot;
+  void Work();
+
+public:
+  explicit AsyncOutputWriter(int workerAmount = 2, size_t capacity = 64);
+  ~AsyncOutputWriter();
+  //The task returns false on failure.
+  void Submit(std::function<bool()> &&task);
+  //Outputs go into the shards instead of separate files, named by their path relative to root.
+  //Set it before submitting.
+  void SetShardWriter(const std::shared_ptr<DatasetShardWriter> &shardWriter,
+                      const std::filesystem::path &root);
+  //Thread safe, writes the data to path or appends it to the shards.
+  bool Commit(const std::filesystem::path &path, const void *data, size_t size);
+  void WriteFile(const std::filesystem::path &path, std::string &&data);
+  //RGBA float pixels, bottom row first as read from OpenGL. ".hdr" keeps floats, ".png" and ".jpg" are 8 bit.
+  void WriteImage(const std::filesystem::path &path, int width, int height,
+                  std::vector<float> &&pixels);
+  //Reads the texture back on the calling thread, which has to own the GL context.
+  void WriteTexture(const std::filesystem::path &path,
+                    const std::shared_ptr<Texture2D> &texture);
+  //Blocks until all submitted tasks are done, returns how many failed since the last flush.
+  int Flush();
+};
+} // namespace EcoSysLab
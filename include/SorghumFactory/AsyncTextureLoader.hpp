@@ -0,0 +1,32 @@
+#pragma once
+#include <future>
+#include <sorghum_factory_export.h>
+
+using namespace UniEngine;
+namespace EcoSysLab {
+//Decodes image files on worker threads and uploads them on the main thread, which owns the
+//GL context. Until then the target texture stays empty, callers keep a placeholder in its place.
+class SORGHUM_FACTORY_API AsyncTextureLoader {
+  struct Task {
+    std::shared_ptr<Texture2D> m_texture;
+    std::function<void(const std::shared_ptr<Texture2D> &)> m_onLoaded;
+    //RGBA pixels, bottom row first as Texture2D::Import stores them. Empty on failure.
+    std::future<std::pair<glm::uvec2, std::vector<glm::vec4>>> m_pixels;
+    std::filesystem::path m_path;
+  };
+  std::vector<Task> m_tasks;
+  void Finish(Task &task);
+
+public:
+  //onLoaded runs on the main thread inside Update or Wait, after the texture has data.
+  void Load(const std::filesystem::path &path,
+            const std::shared_ptr<Texture2D> &texture,
+            std::function<void(const std::shared_ptr<Texture2D> &)> &&onLoaded);
+  //Uploads the textures that finished decoding, call it once per frame.
+  void Update();
+  //Blocks until every texture is uploaded.
+  void Wait();
+  [[nodiscard]] bool Empty() const;
+  ~AsyncTextureLoader();
+};
+} // namespace EcoSysLab
@@ -0,0 +1,84 @@
+#pragma once
+#include <sorghum_factory_export.h>
+
+using namespace UniEngine;
+namespace EcoSysLab {
+//Binary file next to a serialized scene or asset that holds its large arrays, so the YAML only
+//keeps their offset and length. It is active for the thread while a BinarySidecarScope lives,
+//otherwise arrays are written into the YAML as base64 as before.
+class SORGHUM_FACTORY_API BinarySidecar {
+  std::filesystem::path m_path;
+  std::ofstream m_output;
+  size_t m_size = 0;
+  //Arrays are copied into their vectors anyway, so reading goes straight from the stream.
+  mutable std::ifstream m_input;
+  size_t m_inputSize = 0;
+
+public:
+  [[nodiscard]] static BinarySidecar *GetCurrent();
+  static void SetCurrent(BinarySidecar *sidecar);
+  //path + ".bin".
+  [[nodiscard]] static std::filesystem::path
+  GetSidecarPath(const std::filesystem::path &path);
+
+  bool OpenForWrite(const std::filesystem::path &path);
+  bool OpenForRead(const std::filesystem::path &path);
+  [[nodiscard]] bool IsWriting() const;
+  [[nodiscard]] bool IsReading() const;
+  //Appends at a 16 byte aligned offset and returns it.
+  size_t Append(const void *data, size_t size);
+  bool Read(size_t offset, size_t size, void *target) const;
+  bool Close();
+
+  static void Save(const std::string &name, const void *data, size_t size,
+                   YAML::Emitter &out);
+  //For arrays that went into the sidecar, the node is a map of offset and length.
+  [[nodiscard]] static bool IsInSidecar(const YAML::Node &node);
+  [[nodiscard]] static size_t GetSize(const YAML::Node &node);
+  static bool Load(const YAML::Node &node, void *target, size_t size);
+
+  //Exports or imports the asset with its arrays in the sidecar of path.
+  static bool Export(const std::shared_ptr<IAsset> &asset,
+                     const std::filesystem::path &path);
+  static bool Import(const std::shared_ptr<IAsset> &asset,
+                     const std::filesystem::path &path);
+  static void OnInspect(const std::shared_ptr<IAsset> &asset,
+                        const std::string &typeName,
+                        const std::string &extension);
+};
+
+class SORGHUM_FACTORY_API BinarySidecarScope {
+  BinarySidecar *m_previous;
+
+public:
+  explicit BinarySidecarScope(BinarySidecar &sidecar);
+  BinarySidecarScope(const BinarySidecarScope &) = delete;
+  BinarySidecarScope &operator=(const BinarySidecarScope &) = delete;
+  ~BinarySidecarScope();
+};
+
+template <typename T>
+inline void SaveListAsBinary(const std::string &name,
+                             const std::vector<T> &target, YAML::Emitter &out) {
+  if (!target.empty()) {
+    BinarySidecar::Save(name, target.data(), target.size() * sizeof(T), out);
+  }
+}
+template <typename T>
+inline void LoadListFromBinary(const std::string &name, std::vector<T> &target,
+                               const YAML::Node &in) {
+  if (in[name]) {
+    const auto &node = in[name];
+    if (!BinarySidecar::IsInSidecar(node)) {
+      const auto binaryList = node.as<YAML::Binary>();
+      target.resize(binaryList.size() / sizeof(T));
+      std::memcpy(target.data(), binaryList.data(), target.size() * sizeof(T));
+      return;
+    }
+    //Without the sidecar the list keeps what it had.
+    std::vector<T> loaded(BinarySidecar::GetSize(node) / sizeof(T));
+    if (BinarySidecar::Load(node, loaded.data(), loaded.size() * sizeof(T)))
+      target.swap(loaded);
+  }
+}
+} // namespace EcoSysLab
@@ -11,6 +11,7 @@ public:
   void CollectAssetRef(std::vector<AssetRef> &list) override;
   void Serialize(YAML::Emitter &out) override;
   void Deserialize(const YAML::Node &in) override;
+  //Random entry of m_doubleCBTFs, empty when there is none.
   AssetRef GetRandom() const;
 };
 }
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+#include <sorghum_factory_export.h>
+
+using namespace UniEngine;
+namespace EcoSysLab {
+class SorghumField;
+//Accumulates leaf area, leaf inclination histogram and projected cover on a XZ grid.
+//Triangles are buffered and reduced in batches so fields of any size can be streamed plant by plant.
+class SORGHUM_FACTORY_API CanopyRaster : public IAsset {
+  struct TriangleRecord {
+    glm::vec2 m_p0;
+    glm::vec2 m_p1;
+    glm::vec2 m_p2;
+    int m_cell = -1;
+    int m_heightBin = 0;
+    int m_angleBin = 0;
+    float m_area = 0.0f;
+  };
+  //World space triangles waiting for the next flush, 3 positions each.
+  std::vector<glm::vec3> m_pendingTriangles;
+  //One byte per cover sample, m_coverResolution samples per cell edge.
+  std::vector<unsigned char> m_coverMask;
+  //Ground height at each cell center, heights are binned above it.
+  std::vector<float> m_cellGroundHeights;
+  void Flush();
+  [[nodiscard]] glm::ivec2 GetCoverResolution() const;
+
+public:
+  glm::vec2 m_min = glm::vec2(-5.0f);
+  glm::vec2 m_max = glm::vec2(5.0f);
+  float m_cellSize = 0.5f;
+  float m_heightBinSize = 0.1f;
+  int m_heightBinAmount = 30;
+  //Bins over leaf inclination in [0, 90] degrees.
+  int m_angleBinAmount = 9;
+  int m_coverResolution = 8;
+  int m_batchTriangleAmount = 1 << 20;
+  //SorghumField streamed by the inspector.
+  AssetRef m_field;
+  //FieldGround with a generated height cache, without it the ground is flat at the height of m_groundTransform.
+  AssetRef m_ground;
+  //World transform of the entity generated from m_ground, heights are sampled in its space.
+  glm::mat4 m_groundTransform = glm::mat4(1.0f);
+
+  glm::ivec2 m_resolution = glm::ivec2(0);
+  //[cell * m_heightBinAmount + height bin], cell = z * m_resolution.x + x.
+  std::vector<float> m_leafArea;
+  //[cell * m_angleBinAmount + angle bin], area weighted.
+  std::vector<float> m_angleHistogram;
+  //Projected cover fraction per cell.
+  std::vector<float> m_cover;
+
+  void Begin();
+  void AddLeafTriangles(const std::vector<Vertex> &vertices,
+                        const std::vector<glm::uvec3> &triangles,
+                        const glm::mat4 &transform);
+  void End();
+  [[nodiscard]] float GetLeafAreaIndex(int cell) const;
+
+  //Rasterizes every formed sorghum in the scene.
+  void RasterizeScene(const std::shared_ptr<Scene> &scene);
+  //Forms and rasterizes the plants of the field one at a time, without keeping them in the scene.
+  void RasterizeField(const std::shared_ptr<SorghumField> &field);
+
+  void ExportBinary(const std::filesystem::path &path) const;
+  void ExportCSV(const std::filesystem::path &path) const;
+
+  void OnInspect() override;
+  void Serialize(YAML::Emitter &out) override;
+  void Deserialize(const YAML::Node &in) override;
+  void CollectAssetRef(std::vector<AssetRef> &list) override;
+};
+} // namespace EcoSysLab
@@ -0,0 +1,31 @@
+#pragma once
+#include "MappedFile.hpp"
+#include <sorghum_factory_export.h>
+
+using namespace UniEngine;
+namespace EcoSysLab {
+//Memory mapped CSV reader that only parses the bound columns. The first line is the header.
+//Lines are split across threads, so quoted fields must not contain line breaks or commas.
+class SORGHUM_FACTORY_API CsvReader {
+  struct Binding {
+    std::string m_name;
+    int m_column = -1;
+    std::vector<float> *m_floats = nullptr;
+    std::vector<std::string> *m_strings = nullptr;
+  };
+  MappedFile m_file;
+  std::vector<std::string> m_header;
+  size_t m_bodyOffset = 0;
+  std::vector<Binding> m_bindings;
+
+public:
+  bool Open(const std::filesystem::path &path);
+  [[nodiscard]] const std::vector<std::string> &GetHeader() const;
+  //Returns -1 if the column doesn't exist.
+  [[nodiscard]] int GetColumnIndex(const std::string &name) const;
+  void Bind(const std::string &name, std::vector<float> &column);
+  void Bind(const std::string &name, std::vector<std::string> &column);
+  //Fills all bound columns in one pass. Empty numeric cells become NaN.
+  bool Read();
+};
+} // namespace EcoSysLab
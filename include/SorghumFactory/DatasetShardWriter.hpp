@@ -0,0 +1,33 @@
+#pragma once
+#include <sorghum_factory_export.h>
+
+using namespace UniEngine;
+namespace EcoSysLab {
+//Packs many small outputs into a few large append-only shard files. Every entry is listed in
+//index.csv as name, shard, offset, length and type, so a reader can seek straight to it. Names and
+//types are quoted as CSV fields when they contain commas, quotes or line breaks.
+class SORGHUM_FACTORY_API DatasetShardWriter {
+  std::mutex m_mutex;
+  std::filesystem::path m_folder;
+  std::ofstream m_shard;
+  std::ofstream m_index;
+  int m_shardAmount = 0;
+  size_t m_shardSize = 0;
+  size_t m_entryAmount = 0;
+  size_t m_maxShardSize = 0;
+  bool OpenShard();
+
+public:
+  [[nodiscard]] static std::string GetShardName(int shardIndex);
+  bool Open(const std::filesystem::path &folder, size_t maxShardSize);
+  [[nodiscard]] bool IsOpen() const;
+  //Thread safe. A new shard is started when this entry would exceed the shard size.
+  bool Append(const std::string &name, const std::string &type,
+              const void *data, size_t size);
+  void Close();
+  [[nodiscard]] int GetShardAmount() const;
+  [[nodiscard]] size_t GetEntryAmount() const;
+  [[nodiscard]] size_t GetMaxShardSize() const;
+  ~DatasetShardWriter();
+};
+} // namespace EcoSysLab
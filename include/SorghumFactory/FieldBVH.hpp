@@ -0,0 +1,86 @@
+#pragma once
+#include <sorghum_factory_export.h>
+
+using namespace UniEngine;
+namespace EcoSysLab {
+//Flattened in depth-first order, the left child of an inner node is always the next node.
+struct SORGHUM_FACTORY_API FieldBVHNode {
+  glm::vec3 m_min = glm::vec3(FLT_MAX);
+  //Right child for inner nodes, first triangle for leaves.
+  int m_offset = 0;
+  glm::vec3 m_max = glm::vec3(-FLT_MAX);
+  //Triangle count, 0 for inner nodes.
+  int m_count = 0;
+};
+
+struct SORGHUM_FACTORY_API FieldBVHTriangle {
+  glm::vec3 m_v0;
+  glm::vec3 m_v1;
+  glm::vec3 m_v2;
+};
+
+struct SORGHUM_FACTORY_API FieldBVHRayHit {
+  float m_distance = FLT_MAX;
+  glm::vec3 m_position = glm::vec3(0.0f);
+  glm::vec3 m_normal = glm::vec3(0.0f);
+  Entity m_entity;
+  int m_triangleIndex = -1;
+};
+
+//CPU bounding volume hierarchy over world space triangles of mesh renderers, built with binned SAH.
+class SORGHUM_FACTORY_API FieldBVH {
+  struct GeometryRecord {
+    //Root the geometry was collected under and its depth-first position there. Regenerated
+    //plants get new entities and meshes, but their organs come back in the same order.
+    Entity m_root;
+    int m_ordinal = 0;
+    Entity m_entity;
+    std::shared_ptr<Mesh> m_mesh;
+    size_t m_vertexCount = 0;
+    int m_triangleStart = 0;
+    int m_triangleCount = 0;
+  };
+  std::vector<GeometryRecord> m_geometries;
+  std::vector<FieldBVHNode> m_nodes;
+  std::vector<FieldBVHTriangle> m_triangles;
+  //Original triangle index of each sorted triangle, original indices are grouped by geometry.
+  std::vector<int> m_triangleOrder;
+  std::vector<int> m_triangleGeometry;
+
+  //Mesh renderers with triangles under the roots, in depth-first order.
+  static void CollectGeometries(const std::shared_ptr<Scene> &scene,
+                                const std::vector<Entity> &roots,
+                                std::vector<GeometryRecord> &geometries);
+  void CollectTriangles(const std::shared_ptr<Scene> &scene,
+                        std::vector<FieldBVHTriangle> &triangles) const;
+  int BuildNode(int start, int end, std::vector<glm::vec3> &centroids);
+  void UpdateBounds();
+  template <typename Overlap>
+  void Query(const Overlap &overlap, std::vector<Entity> &entities) const;
+
+public:
+  int m_maxLeafSize = 4;
+  //Collects every mesh renderer under the given roots, including the roots themselves.
+  void Build(const std::shared_ptr<Scene> &scene,
+             const std::vector<Entity> &roots);
+  //Updates vertex positions and bounds without changing the tree. Returns false and leaves
+  //the tree untouched when the geometries under the roots differ from the ones it was built
+  //from, e.g. an organ was added or removed or its vertex or triangle count changed.
+  bool Refit(const std::shared_ptr<Scene> &scene,
+             const std::vector<Entity> &roots);
+  void Clear();
+  [[nodiscard]] bool Empty() const;
+  [[nodiscard]] size_t GetNodeAmount() const;
+  [[nodiscard]] size_t GetTriangleAmount() const;
+  void GetBound(glm::vec3 &min, glm::vec3 &max) const;
+
+  bool RayCast(const glm::vec3 &origin, const glm::vec3 &direction,
+               FieldBVHRayHit &hit, float maxDistance = FLT_MAX) const;
+  //Entities with at least one triangle whose bounding box overlaps [min, max].
+  void QueryAABB(const glm::vec3 &min, const glm::vec3 &max,
+                 std::vector<Entity> &entities) const;
+  //Entities with geometry inside the frustum described by a view projection matrix.
+  void FrustumCull(const glm::mat4 &viewProjection,
+                   std::vector<Entity> &entities) const;
+};
+} // namespace EcoSysLab
@@ -11,17 +11,37 @@ namespace EcoSysLab {
 		float m_heightMax = 10;
 	};
 	class SORGHUM_FACTORY_API FieldGround : public IAsset {
+		//Evaluates heights for grid vertices in [start, end] (inclusive), rows along x are processed in parallel.
+		void GenerateHeights(const glm::ivec2& start, const glm::ivec2& end, float depth,
+			const glm::vec3& randomPositionOffset, std::vector<float>& heights) const;
+		void GenerateGeometry(const glm::ivec2& start, const glm::ivec2& end, const std::vector<float>& heights,
+			std::vector<Vertex>& vertices, std::vector<glm::uvec3>& triangles) const;
+		//Heights of the last generated ground, in local space of the ground entity.
+		std::vector<float> m_heights;
+		glm::ivec2 m_heightCacheStart = glm::ivec2(0);
+		glm::ivec2 m_heightCacheSize = glm::ivec2(0);
+		float GetCachedHeight(int row, int column) const;
 	public:
 		glm::vec2 m_scale = glm::vec2(0.02f);
 		glm::ivec2 m_size = glm::ivec2(150);
 		float m_rowWidth = 0.0f;
 		float m_alleyDepth = 0.15f;
+		//Vertices per tile edge for GenerateTiledMesh, 0 disables tiling.
+		int m_tileSize = 0;
 
 		std::vector<NoiseDescriptor> m_noiseDescriptors;
 		void OnCreate() override;
 		Entity GenerateMesh(float overrideDepth = -1.0f);
+		Entity GenerateTiledMesh(float overrideDepth = -1.0f);
+
+		bool HasHeightCache() const;
+		//Bilinear height of the last generated ground at local (x, z), clamped to the ground border.
+		float SampleHeight(float x, float z) const;
+		glm::vec3 SampleNormal(float x, float z) const;
+		//Samples all (x, z) positions in parallel.
+		void SampleHeights(const std::vector<glm::vec2>& positions, std::vector<float>& heights) const;
 		void OnInspect() override;
 		void Serialize(YAML::Emitter& out) override;
 		void Deserialize(const YAML::Node& in) override;
 	};
-}
\ No newline at end of file
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include "TextTokenizer.hpp"
 #include <sorghum_factory_export.h>
 using namespace UniEngine;
 namespace EcoSysLab {
@@ -24,7 +25,8 @@ public:
 class SORGHUM_FACTORY_API BezierSpline{
 public:
   std::vector<BezierCurve> m_curves;
-  void Import(std::ifstream &stream);
+  //Curve amount followed by 4 control points per curve as x z y, returns false on malformed input.
+  bool Import(TextTokenizer &tokenizer);
   [[nodiscard]] glm::vec3 EvaluateAxisFromCurves(float point) const;
   [[nodiscard]] glm::vec3 EvaluatePointFromCurves(float point) const;
   void OnInspect();
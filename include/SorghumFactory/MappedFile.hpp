@@ -0,0 +1,28 @@
+#pragma once
+#include <sorghum_factory_export.h>
+
+using namespace UniEngine;
+namespace EcoSysLab {
+//Read only memory mapping of a whole file.
+class SORGHUM_FACTORY_API MappedFile {
+  const unsigned char *m_data = nullptr;
+  size_t m_size = 0;
+#ifdef _WIN32
+  void *m_fileHandle = nullptr;
+  void *m_mappingHandle = nullptr;
+#else
+  int m_fileDescriptor = -1;
+#endif
+public:
+  MappedFile() = default;
+  explicit MappedFile(const std::filesystem::path &path);
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile();
+  bool Open(const std::filesystem::path &path);
+  void Close();
+  [[nodiscard]] bool IsOpen() const;
+  [[nodiscard]] const unsigned char *GetData() const;
+  [[nodiscard]] size_t GetSize() const;
+};
+} // namespace EcoSysLab
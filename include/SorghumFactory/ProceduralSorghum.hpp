@@ -67,6 +67,9 @@ public:
   ProceduralStemState m_stem;
   std::vector<ProceduralLeafState> m_leaves;
   bool OnInspect(int mode);
+  //Reads a CubicBezier skeleton text file (skeleton_procedural_*.txt) into stem and leaves.
+  bool ImportSkeleton(TextTokenizer &tokenizer);
+  bool ImportSkeleton(const std::filesystem::path &path, std::string &error);
 
   void Serialize(YAML::Emitter &out);
   void Deserialize(const YAML::Node &in);
@@ -92,6 +95,11 @@ class ProceduralSorghum : public IAsset {
 public:
   int m_mode = (int)StateMode::Default;
   [[nodiscard]] bool ImportCSV(const std::filesystem::path &filePath);
+  //Replaces the states with one CubicBezier state per skeleton_procedural_*.txt file in the folder,
+  //ordered by file name. Files are parsed in parallel and the ones that fail are listed in errors
+  //and skipped. The states are left untouched when no file could be imported.
+  int ImportSkeletons(const std::filesystem::path &folder,
+                      std::vector<std::string> &errors);
   [[nodiscard]] unsigned GetVersion() const;
   [[nodiscard]] float GetCurrentStartTime() const;
   [[nodiscard]] float GetCurrentEndTime() const;
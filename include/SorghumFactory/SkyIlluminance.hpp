@@ -7,18 +7,83 @@ struct SORGHUM_FACTORY_API SkyIlluminanceSnapshot {
   float m_ghi = 1000;
   float m_azimuth = 0;
   float m_zenith = 0;
-  [[nodiscard]] glm::vec3 GetSunDirection();
-  [[nodiscard]] float GetSunIntensity();
+  //Precomputed from azimuth and zenith when the snapshot comes from SkyIlluminance.
+  glm::vec3 m_sunDirection = glm::vec3(0, 1, 0);
+  [[nodiscard]] static glm::vec3 ComputeSunDirection(float azimuth,
+                                                     float zenith);
+  [[nodiscard]] glm::vec3 GetSunDirection() const;
+  [[nodiscard]] float GetSunIntensity() const;
 };
+struct SORGHUM_FACTORY_API SunDirectionBin {
+  //Energy weighted mean sun direction within the bin.
+  glm::vec3 m_direction = glm::vec3(0, 1, 0);
+  //GHI integrated over time, in GHI times the unit of the time column.
+  float m_energy = 0;
+};
+//Snapshots are kept as sorted arrays, one per field. Lookups use binary search, or direct
+//indexing when the samples are evenly spaced in time.
 class SORGHUM_FACTORY_API SkyIlluminance : public IAsset {
+  std::vector<float> m_times;
+  std::vector<float> m_ghis;
+  std::vector<float> m_azimuths;
+  std::vector<float> m_zeniths;
+  std::vector<glm::vec3> m_sunDirections;
+  //Larger than 0 when all samples are this far apart.
+  float m_uniformInterval = 0;
+  //Index of the snapshot before time and the weight of the one after it.
+  void Locate(float time, size_t &index, float &weight) const;
+
+  //GHI is linear between snapshots, segment i spans snapshot i to i + 1.
+  //Integral of GHI from the first snapshot to each snapshot.
+  std::vector<double> m_ghiIntegrals;
+  std::vector<glm::vec3> m_segmentDirections;
+  //-1 for segments below the horizon.
+  std::vector<int> m_segmentBins;
+  //Segments of each bin in time order, with prefix sums of their energy and energy weighted direction.
+  std::vector<std::vector<unsigned>> m_binSegments;
+  std::vector<std::vector<double>> m_binEnergyIntegrals;
+  std::vector<std::vector<glm::dvec3>> m_binDirectionIntegrals;
+  void BuildIntegrals();
+  [[nodiscard]] double IntegrateSegment(size_t segment, float startTime,
+                                        float endTime) const;
+  [[nodiscard]] double GetIntegral(float time) const;
+
 public:
-  std::map<float, SkyIlluminanceSnapshot> m_snapshots;
-  float m_minTime;
-  float m_maxTime;
-  [[nodiscard]] SkyIlluminanceSnapshot Get(float time);
+  float m_minTime = 0;
+  float m_maxTime = 0;
+  int m_azimuthBinAmount = 36;
+  int m_zenithBinAmount = 9;
+  //Sun position from the solar model instead of the Azimuth and Zenith columns. Times are
+  //minutes since midnight UTC of the start date, queries between snapshots get the exact position.
+  bool m_computeSunPosition = false;
+  double m_latitude = 33.073528;
+  double m_longitude = -111.973816;
+  glm::ivec3 m_startDate = glm::ivec3(2021, 7, 7);
+  //Samples may come in any order, the last one wins for duplicated times.
+  void SetSnapshots(const std::vector<float> &times,
+                    const std::vector<float> &ghis,
+                    const std::vector<float> &azimuths,
+                    const std::vector<float> &zeniths);
+  [[nodiscard]] size_t GetSnapshotAmount() const;
+  [[nodiscard]] float GetSnapshotTime(size_t index) const;
+  [[nodiscard]] SkyIlluminanceSnapshot GetSnapshot(size_t index) const;
+  [[nodiscard]] SkyIlluminanceSnapshot Get(float time) const;
+  void GetBatch(const std::vector<float> &times,
+                std::vector<SkyIlluminanceSnapshot> &snapshots) const;
+  //Returns -1 below the horizon.
+  [[nodiscard]] int GetBinIndex(float azimuth, float zenith) const;
+  //GHI integrated over the window, which is clamped to the time range of the snapshots.
+  [[nodiscard]] float Integrate(float startTime, float endTime) const;
+  //The energy of the window split by sun direction, only bins with energy are listed.
+  //Costs O(bins * log(snapshots)) regardless of the window length.
+  void GetSunDirectionHistogram(float startTime, float endTime,
+                                std::vector<SunDirectionBin> &bins) const;
+  [[nodiscard]] double GetJulianDay(float time) const;
+  //Replaces azimuth and zenith of all snapshots with the solar model.
+  void ComputeSunPositions();
   void ImportCSV(const std::filesystem::path &path);
   void OnInspect() override;
   void Serialize(YAML::Emitter &out) override;
   void Deserialize(const YAML::Node &in) override;
 };
-} // namespace EcoSysLab
\ No newline at end of file
+} // namespace EcoSysLab
@@ -0,0 +1,21 @@
+#pragma once
+#include <sorghum_factory_export.h>
+
+using namespace UniEngine;
+namespace EcoSysLab {
+//Solar position from the NOAA solar calculator equations, within about 0.01 degree for years
+//1800 to 2100. Azimuth follows the Solcast data: degrees from north, positive towards west,
+//in (-180, 180]. Zenith includes atmospheric refraction. All angles are in degrees.
+class SORGHUM_FACTORY_API SolarPosition {
+public:
+  //Julian day of a UTC date, hour may be fractional.
+  [[nodiscard]] static double GetJulianDay(int year, int month, int day,
+                                           double hour = 0.0);
+  static void Compute(double latitude, double longitude, double julianDay,
+                      float &azimuth, float &zenith);
+  //Same as above for a whole series, split across threads for long ones.
+  static void Compute(double latitude, double longitude,
+                      const std::vector<double> &julianDays,
+                      std::vector<float> &azimuths, std::vector<float> &zeniths);
+};
+} // namespace EcoSysLab
@@ -0,0 +1,28 @@
+#pragma once
+#include "SorghumMeshWriter.hpp"
+#include <sorghum_factory_export.h>
+
+using namespace UniEngine;
+namespace EcoSysLab {
+class SorghumStateGenerator;
+//Forms the plants of a SorghumStateGenerator over a seed range without creating entities,
+//and writes one mesh file per seed. The generator seeds the global random state, so plants are
+//formed one by one on the calling thread and handed to writer threads through a bounded queue.
+class SORGHUM_FACTORY_API SorghumBatchExporter {
+public:
+  unsigned m_seedStart = 0;
+  //Exclusive.
+  unsigned m_seedEnd = 100;
+  SorghumMeshFormat m_format = SorghumMeshFormat::Ply;
+  //Formed plants waiting to be written, bounds the memory used.
+  int m_queueSize = 16;
+  int m_writerAmount = 2;
+  bool m_skeleton = false;
+  std::string m_prefix = "Sorghum_";
+
+  //Returns false when any file could not be written.
+  bool Export(const std::shared_ptr<SorghumStateGenerator> &generator,
+              const std::filesystem::path &folder) const;
+  void OnInspect(const std::shared_ptr<SorghumStateGenerator> &generator);
+};
+} // namespace EcoSysLab
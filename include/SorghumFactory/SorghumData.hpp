@@ -14,6 +14,8 @@ class SORGHUM_FACTORY_API SorghumData : public IPrivateComponent {
   unsigned m_recordedVersion = 0;
   friend class SorghumLayer;
   bool m_segmentedMask = false;
+  bool m_geometryPending = false;
+  bool m_impostor = false;
 public:
   int m_mode = (int)SorghumMode::ProceduralSorghum;
   glm::vec3 m_gravityDirection = glm::vec3(0, -1, 0);
@@ -24,18 +26,44 @@ public:
   bool m_seperated = true;
   bool m_includeStem = true;
   bool m_bottomFace = false;
+  //Only the generative inputs are saved, the organs are rebuilt the first time they are needed.
+  bool m_lazyGeneration = false;
+
+  //Loaded without geometry and not rebuilt yet.
+  [[nodiscard]] bool IsGeometryPending() const;
+  //Whether the plant is drawn with a convex hull proxy and has no organs.
+  [[nodiscard]] bool IsImpostor() const;
+  //Full geometry also replaces an impostor, for paths that read the organs.
+  void EnsureGeometry(bool fullGeometry = false);
+  //Deletes the organs with their generated meshes and marks the plant pending.
+  void ReleaseGeometry();
+  //Whether the organ belongs to a plant that saves only its inputs.
+  [[nodiscard]] static bool IsLazyOrgan(const std::shared_ptr<Scene> &scene,
+                                        const Entity &organ);
 
   void OnCreate() override;
   void OnDestroy() override;
   void OnInspect() override;
+  //Forms the plant at the given growth time.
   void SetTime(float time);
+  //Only stores the growth time, the plant is formed later.
+  void SetCurrentTime(float time);
+  [[nodiscard]] float GetCurrentTime() const;
+  //Marks the current geometry as built from the descriptor as it is now, so auto refresh keeps it.
+  void RecordDescriptorVersion();
   void ExportModel(const std::string &filename,
-                   const bool &includeFoliage = true) const;
+                   const bool &includeFoliage = true);
+  //Binary PLY or glTF by extension, with organ labels.
+  void ExportMesh(const std::filesystem::path &path);
   void Serialize(YAML::Emitter &out) override;
   void Deserialize(const YAML::Node &in) override;
   void CollectAssetRef(std::vector<AssetRef> &list) override;
   void FormPlant();
   void ApplyGeometry();
+  //Collects vertex positions of the formed organs, in plant space.
+  void CollectPoints(std::vector<glm::vec3> &points) const;
+  //Replaces the organs with a single proxy mesh.
+  void ApplyImpostor(const std::shared_ptr<Mesh> &impostor);
 
   void SetEnableSegmentedMask(bool value);
 };
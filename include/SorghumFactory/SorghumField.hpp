@@ -1,8 +1,10 @@
 #pragma once
+#include "BinarySidecar.hpp"
 #include <sorghum_factory_export.h>
 
 using namespace UniEngine;
 namespace EcoSysLab {
+class FieldGround;
 
 class SORGHUM_FACTORY_API RectangularSorghumFieldPattern {
 public:
@@ -12,18 +14,49 @@ public:
   void GenerateField(std::vector<std::vector<glm::mat4>> &matricesList);
 };
 
+//Serialized form of one plant in a field, TRS is stored instead of the full matrix.
+struct SORGHUM_FACTORY_API SorghumFieldPlant {
+  int m_descriptorIndex = 0;
+  int m_seed = 0;
+  glm::vec3 m_position = glm::vec3(0.0f);
+  glm::quat m_rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+  glm::vec3 m_scale = glm::vec3(1.0f);
+};
+
+struct SORGHUM_FACTORY_API NewSorghum {
+  //Index into SorghumField::m_descriptors.
+  int m_descriptorIndex = 0;
+  int m_seed = 0;
+  glm::mat4 m_transform = glm::mat4(1.0f);
+};
+
   class SORGHUM_FACTORY_API SorghumField : public IAsset {
   friend class SorghumLayer;
 
 public:
   bool m_seperated = false;
   bool m_includeStem = true;
+  //Plants save only their generative inputs, see SorghumData::m_lazyGeneration.
+  bool m_lazyGeneration = false;
 
   int m_sizeLimit = 2000;
   float m_sorghumSize = 1.0f;
-  std::vector<std::pair<AssetRef, glm::mat4>> m_newSorghums;
+  //Descriptor table shared by all plants of the field.
+  std::vector<AssetRef> m_descriptors;
+  std::vector<NewSorghum> m_newSorghums;
+  //Returns the table index of the descriptor, adding it when missing.
+  int AddDescriptor(const AssetRef &descriptor);
+  void ClearPlants();
   virtual void GenerateMatrices(){};
   Entity InstantiateField();
+  //Packs the organ geometry and transforms of an instantiated field into one memory mappable file.
+  static bool SaveSnapshot(const std::shared_ptr<Scene> &scene, const Entity &field,
+                           const std::filesystem::path &path);
+  //Recreates a field from a snapshot without forming the plants again. Descriptors are stored by
+  //handle and come back only when the asset is part of the loaded project.
+  static Entity RestoreSnapshot(const std::filesystem::path &path);
+  //Moves every generated plant onto the cached heightfield of the ground, groundHeight is the y of the ground entity.
+  void SnapToGround(const FieldGround &ground, float groundHeight = 0.0f);
 
   void OnInspect() override;
   void Serialize(YAML::Emitter &out) override;
@@ -70,22 +103,50 @@ public:
   void CollectAssetRef(std::vector<AssetRef> &list) override;
 };
 
-template <typename T>
-inline void SaveListAsBinary(const std::string &name,
-                             const std::vector<T> &target, YAML::Emitter &out) {
-  if (!target.empty()) {
-    out << YAML::Key << name << YAML::Value
-        << YAML::Binary((const unsigned char *)target.data(),
-                        target.size() * sizeof(T));
-  }
-}
-template <typename T>
-inline void LoadListFromBinary(const std::string &name, std::vector<T> &target,
-                               const YAML::Node &in) {
-  if (in[name]) {
-    auto binaryList = in[name].as<YAML::Binary>();
-    target.resize(binaryList.size() / sizeof(T));
-    std::memcpy(target.data(), binaryList.data(), binaryList.size());
-  }
-}
+class SORGHUM_FACTORY_API RowSorghumField : public SorghumField {
+  friend class SorghumLayer;
+
+public:
+  AssetRef m_sorghumStateGenerator;
+  int m_rowAmount = 8;
+  float m_rowLength = 10.0f;
+  float m_rowSpacing = 0.76f;
+  float m_inRowSpacing = 0.1f;
+  float m_inRowSpacingVariance = 0.02f;
+  //Chance for each seed position to carry a plant.
+  float m_emergenceProbability = 0.85f;
+  //Rotation of the rows around y axis, in degrees.
+  float m_rowOrientation = 0.0f;
+  glm::vec3 m_rotationVariance = glm::vec3(0.0f);
+  void GenerateMatrices() override;
+
+  void OnInspect() override;
+  void Serialize(YAML::Emitter &out) override;
+  void Deserialize(const YAML::Node &in) override;
+  void CollectAssetRef(std::vector<AssetRef> &list) override;
+};
+
+class SORGHUM_FACTORY_API PoissonDiskSorghumField : public SorghumField {
+  friend class SorghumLayer;
+
+public:
+  AssetRef m_sorghumStateGenerator;
+  glm::vec2 m_size = glm::vec2(10.0f);
+  float m_minDistance = 0.3f;
+  //Candidates tried around each active sample before it is retired.
+  int m_attempts = 30;
+  int m_seed = 0;
+  glm::vec3 m_rotationVariance = glm::vec3(0.0f);
+  //Sample positions on XZ plane, centered at origin.
+  std::vector<glm::vec2> m_points;
+  //Bridson's dart throwing with a background grid, linear in the number of samples.
+  void GeneratePoints();
+  void GenerateMatrices() override;
+
+  void OnInspect() override;
+  void Serialize(YAML::Emitter &out) override;
+  void Deserialize(const YAML::Node &in) override;
+  void CollectAssetRef(std::vector<AssetRef> &list) override;
+};
+
 } // namespace EcoSysLab
\ No newline at end of file
@@ -2,6 +2,8 @@
 #ifdef RAYTRACERFACILITY
 #include <CUDAModule.hpp>
 #endif
+#include "AsyncTextureLoader.hpp"
+#include "FieldBVH.hpp"
 #include "ILayer.hpp"
 #include "PointCloud.hpp"
 #include "SorghumField.hpp"
@@ -24,10 +26,31 @@ class SorghumStateGenerator;
 
 
 class SORGHUM_FACTORY_API SorghumLayer : public ILayer {
-  static void ObjExportHelper(glm::vec3 position, std::shared_ptr<Mesh> mesh,
-                              std::ofstream &of, unsigned &startIndex);
+  //Appends the mesh in OBJ text, indices are offset by startIndex which then advances.
+  static void ObjExportHelper(glm::vec3 position,
+                              const std::shared_ptr<Mesh> &mesh,
+                              std::string &buffer, unsigned &startIndex);
+  static void CollectExportMeshes(const std::shared_ptr<Scene> &scene,
+                                  const Entity &sorghum,
+                                  std::vector<std::shared_ptr<Mesh>> &meshes);
+  static void ExportSorghum(const glm::vec3 &position,
+                            const std::vector<std::shared_ptr<Mesh>> &meshes,
+                            std::string &buffer, unsigned &startIndex);
+  struct ImpostorRecord {
+    unsigned m_version = 0;
+    std::shared_ptr<Mesh> m_mesh;
+  };
+  //Convex hull proxies keyed by descriptor handle, quantized growth time and variant.
+  std::map<std::tuple<uint64_t, int, int>, ImpostorRecord> m_impostors;
+  AsyncTextureLoader m_textureLoader;
+  static bool m_headless;
 
 public:
+  //Set before the layer is pushed. Headless runs skip the editor icons.
+  static void SetHeadless(bool value);
+  [[nodiscard]] static bool IsHeadless();
+  //Blocks until the textures queued at startup are uploaded, headless captures need them.
+  void WaitForTextures();
 #ifdef RAYTRACERFACILITY
 #pragma region Illumination
   int m_seed = 0;
@@ -53,6 +76,8 @@ public:
 
   bool m_enableBottomFace = false;
   bool m_autoRefreshSorghums = true;
+  //Plants loaded without geometry that are rebuilt per frame.
+  int m_lazyGenerationBudget = 16;
   EntityArchetype m_leafArchetype;
   EntityQuery m_leafQuery;
   EntityArchetype m_sorghumArchetype;
@@ -87,6 +112,20 @@ public:
 
   glm::vec3 m_skeletonColor = glm::vec3(0);
 
+  bool m_enableImpostors = false;
+  //Plants farther than this from the impostor center are replaced by a convex hull proxy.
+  float m_impostorDistance = 10.0f;
+  glm::vec3 m_impostorCenter = glm::vec3(0.0f);
+  //Growth times within one step share a proxy.
+  float m_impostorTimeStep = 0.1f;
+  //Proxies baked per descriptor, plants pick one by seed.
+  int m_impostorVariants = 4;
+  void ClearImpostors();
+
+  FieldBVH m_fieldBVH;
+  //Refits the BVH over all sorghums, rebuilds it when the plants changed.
+  void UpdateFieldBVH();
+
   void OnCreate() override;
   Entity CreateSorghum();
   Entity CreateSorghum(const std::shared_ptr<ProceduralSorghum> &descriptor);
@@ -96,13 +135,25 @@ public:
   Entity CreateSorghumLeaf(const Entity &plantEntity, int leafIndex);
   Entity CreateSorghumPanicle(const Entity &plantEntity);
   void GenerateMeshForAllSorghums();
+  void GenerateMeshForSorghum(const Entity &plant);
+  //Rebuilds every plant that was loaded without geometry, called before exporting or tracing.
+  //Full geometry also replaces impostors, for paths that read the organs.
+  void GeneratePendingSorghums(bool fullGeometry = false);
+  //Drops the organs of plants that save only their inputs, LateUpdate rebuilds them.
+  void ReleaseLazySorghums();
+  //Saves the scene to its own file with the organs of those plants released first.
+  bool SaveScene();
   void OnInspect() override;
   void Update() override;
   void LateUpdate() override;
 
   static void ExportSorghum(const Entity &sorghum, std::ofstream &of,
                             unsigned &startIndex);
+  static void ExportSorghum(const Entity &sorghum, std::string &buffer,
+                            unsigned &startIndex);
   void ExportAllSorghumsModel(const std::string &filename);
+  //Binary PLY or glTF by extension, written plant by plant.
+  void ExportAllSorghumsMesh(const std::filesystem::path &path);
 
 
 };
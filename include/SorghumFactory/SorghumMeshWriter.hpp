@@ -0,0 +1,85 @@
+#pragma once
+#include <sstream>
+#include <sorghum_factory_export.h>
+
+using namespace UniEngine;
+namespace EcoSysLab {
+enum class SorghumOrganType : unsigned char { Stem = 0, Leaf = 1, Panicle = 2 };
+
+struct SORGHUM_FACTORY_API SorghumOrganMesh {
+  const std::vector<Vertex> *m_vertices = nullptr;
+  const std::vector<glm::uvec3> *m_triangles = nullptr;
+  SorghumOrganType m_type = SorghumOrganType::Stem;
+  //Starts from 1 for leaves and is 0 for stem and panicle, same as the point cloud labels.
+  unsigned short m_leafIndex = 0;
+};
+
+//Organ geometry of one plant in plant space. The arrays are referenced unless MakeOwned is called.
+struct SORGHUM_FACTORY_API SorghumPlantMesh {
+  glm::mat4 m_transform = glm::mat4(1.0f);
+  std::vector<SorghumOrganMesh> m_organs;
+  std::vector<std::vector<Vertex>> m_ownedVertices;
+  std::vector<std::vector<glm::uvec3>> m_ownedTriangles;
+  void Collect(const std::shared_ptr<Scene> &scene, const Entity &sorghum);
+  //Copies the referenced arrays so the mesh outlives the organs, e.g. for a background writer.
+  void MakeOwned();
+};
+
+enum class SorghumMeshFormat { Ply, Glb };
+
+//Streams plants into a binary PLY or a glTF 2.0 binary (.glb) file, one plant at a time.
+//Data that has to come after what is still being written (PLY faces, glTF buffer)
+//goes to a temporary file next to the output and is appended on Close.
+//Opened without a path, the output and the temporary data are kept in memory instead.
+class SORGHUM_FACTORY_API SorghumMeshWriter {
+  SorghumMeshFormat m_format = SorghumMeshFormat::Ply;
+  std::filesystem::path m_path;
+  std::filesystem::path m_temporaryPath;
+  std::ofstream m_file;
+  std::ofstream m_temporary;
+  std::ostringstream m_memory;
+  std::ostringstream m_memoryTemporary;
+  bool m_inMemory = false;
+  //Point to the files or the memory streams while open.
+  std::ostream *m_output = nullptr;
+  std::ostream *m_temporaryOutput = nullptr;
+  std::string m_data;
+  std::string m_buffer;
+  unsigned m_plantAmount = 0;
+  size_t m_vertexAmount = 0;
+  size_t m_triangleAmount = 0;
+  //PLY, position of the zero padded counts in the header.
+  std::streamoff m_vertexCountOffset = 0;
+  std::streamoff m_faceCountOffset = 0;
+  //glTF, comma separated json arrays.
+  std::string m_nodes;
+  std::string m_meshes;
+  std::string m_accessors;
+  std::string m_bufferViews;
+  size_t m_binaryLength = 0;
+  unsigned m_meshAmount = 0;
+  unsigned m_accessorAmount = 0;
+
+  void WritePly(const SorghumPlantMesh &plant);
+  void WriteGlb(const SorghumPlantMesh &plant);
+  bool ClosePly();
+  bool CloseGlb();
+  void AddBufferView(size_t byteLength, int target);
+  void Begin();
+  //Appends the temporary data to the output.
+  void AppendTemporary();
+
+public:
+  //Picks the format from ".ply" or ".glb".
+  static bool GetFormat(const std::filesystem::path &path,
+                        SorghumMeshFormat &format);
+  bool Open(const std::filesystem::path &path, SorghumMeshFormat format);
+  //Writes into memory, the finished file is taken with TakeData after Close.
+  bool Open(SorghumMeshFormat format);
+  [[nodiscard]] bool IsOpen() const;
+  void Write(const SorghumPlantMesh &plant);
+  bool Close();
+  [[nodiscard]] std::string TakeData();
+  ~SorghumMeshWriter();
+};
+} // namespace EcoSysLab
@@ -0,0 +1,36 @@
+#pragma once
+#include <charconv>
+#include <sorghum_factory_export.h>
+
+using namespace UniEngine;
+namespace EcoSysLab {
+//Reads whitespace separated numbers from a text buffer with from_chars, without locale or stream overhead.
+class TextTokenizer {
+  const char *m_current = nullptr;
+  const char *m_end = nullptr;
+  void SkipWhitespace() {
+    while (m_current < m_end && (*m_current == ' ' || *m_current == '\n' ||
+                                 *m_current == '\r' || *m_current == '\t'))
+      m_current++;
+  }
+
+public:
+  TextTokenizer(const char *begin, const char *end)
+      : m_current(begin), m_end(end) {}
+  //False at the end of the text or if the next token isn't a number of this type.
+  template <typename T> bool Read(T &value) {
+    SkipWhitespace();
+    if (m_current < m_end && *m_current == '+')
+      m_current++;
+    const auto result = std::from_chars(m_current, m_end, value);
+    if (result.ec != std::errc())
+      return false;
+    m_current = result.ptr;
+    return true;
+  }
+  [[nodiscard]] bool AtEnd() {
+    SkipWhitespace();
+    return m_current >= m_end;
+  }
+};
+} // namespace EcoSysLab
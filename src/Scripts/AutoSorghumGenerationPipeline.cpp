@@ -115,6 +115,8 @@ void AutoSorghumGenerationPipeline::OnInspect() {
     } else if (Application::IsPlaying()) {
       if (ImGui::Button("Start")) {
         m_busy = true;
+        //Captures must not see the placeholder textures.
+        Application::GetLayer<SorghumLayer>()->WaitForTextures();
         behaviour->OnStart(*this);
         m_status = AutoSorghumGenerationPipelineStatus::Idle;
       }
@@ -21,6 +21,7 @@ void Scripts::CBTFImporter::OnInspect() {
       "Collect CBTF Folders",
       [&](const std::filesystem::path &path) {
         m_importFolders.clear();
+        m_totalFolders = m_finishedFolders = m_failedFolders = 0;
         auto &projectManager = ProjectManager::GetInstance();
         if (std::filesystem::exists(path) &&
             std::filesystem::is_directory(path)) {
@@ -43,32 +44,98 @@ void Scripts::CBTFImporter::OnInspect() {
 
   ImGui::Text(
       ("Remaining Folders: " + std::to_string(m_importFolders.size())).c_str());
+  if (m_totalFolders > 0) {
+    ImGui::ProgressBar((float)m_finishedFolders / m_totalFolders,
+                       ImVec2(-1, 0),
+                       (std::to_string(m_finishedFolders) + "/" +
+                        std::to_string(m_totalFolders))
+                           .c_str());
+    if (m_failedFolders > 0)
+      ImGui::Text("Failed: %d", m_failedFolders);
+  }
 
   if(m_processing){
     if(ImGui::Button("Pause")){
       m_processing = false;
     }
   } else {
-    if(Application::IsPlaying() && !m_importFolders.empty()){
-      if(ImGui::Button("Process")){
-        m_processing = true;
+    if (m_task.valid()) {
+      ImGui::Text("Finishing current folder...");
+    } else {
+      if (Application::IsPlaying() && !m_importFolders.empty()) {
+        if (ImGui::Button("Process")) {
+          m_processing = true;
+          if (m_finishedFolders == m_totalFolders) {
+            m_totalFolders = m_importFolders.size();
+            m_finishedFolders = m_failedFolders = 0;
+          }
+        }
+      }
+      if (!m_importFolders.empty() && ImGui::Button("Clear")) {
+        m_importFolders.clear();
+        m_totalFolders = m_finishedFolders = m_failedFolders = 0;
       }
     }
-    if(!m_importFolders.empty() && ImGui::Button("Clear")) m_importFolders.clear();
   }
 }
+
+void Scripts::CBTFImporter::CollectFinishedTask(bool wait) {
+  if (!m_task.valid())
+    return;
+  if (!wait &&
+      m_task.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    return;
+  if (!m_task.get())
+    m_failedFolders++;
+  m_finishedFolders++;
+}
+
 void Scripts::CBTFImporter::Update() {
-  if(!m_processing) return;
-  if(m_importFolders.empty()){
-    m_processing = false;
+  CollectFinishedTask(false);
+  if (!m_processing)
+    return;
+  if (m_importFolders.empty()) {
+    if (!m_task.valid()) {
+      m_processing = false;
+      UNIENGINE_LOG("CBTF import finished, " +
+                    std::to_string(m_finishedFolders - m_failedFolders) +
+                    " exported, " + std::to_string(m_failedFolders) +
+                    " failed.");
+    }
     return;
   }
-  auto path = m_importFolders.back();
-  m_importFolders.pop_back();
 #ifdef RAYTRACERFACILITY
-  auto asset = ProjectManager::CreateTemporaryAsset<CompressedBTF>();
-  asset->ImportFromFolder(path);
-  asset->Export(m_currentExportFolder.string() + "\\" + path.filename().string() + ".cbtf");
+  //Assets are created here since the project manager isn't thread safe, only the import and
+  //compression of the folder run in the background.
+  if (!m_task.valid()) {
+    auto path = m_importFolders.back();
+    m_importFolders.pop_back();
+    auto asset = ProjectManager::CreateTemporaryAsset<CompressedBTF>();
+    auto exportPath =
+        m_currentExportFolder / (path.filename().string() + ".cbtf");
+    m_task = std::async(
+        std::launch::async, [asset, path, exportPath]() {
+          try {
+            //A file left by an earlier run must not count as exported.
+            std::filesystem::remove(exportPath);
+            asset->ImportFromFolder(path);
+            asset->Export(exportPath);
+          } catch (const std::exception &e) {
+            UNIENGINE_ERROR("Failed to import " + path.string() + ": " +
+                            e.what());
+            return false;
+          }
+          return std::filesystem::exists(exportPath);
+        });
+  }
+#else
+  m_failedFolders += m_importFolders.size();
+  m_finishedFolders += m_importFolders.size();
+  m_importFolders.clear();
 #endif
+}
 
+void Scripts::CBTFImporter::OnDestroy() {
+  m_processing = false;
+  CollectFinishedTask(true);
 }
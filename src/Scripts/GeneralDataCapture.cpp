@@ -4,6 +4,7 @@
 #ifdef RAYTRACERFACILITY
 #include "GeneralDataCapture.hpp"
 #include "Prefab.hpp"
+#include "SorghumMeshWriter.hpp"
 #include "TransformLayer.hpp"
 #include <SorghumData.hpp>
 #include <SorghumStateGenerator.hpp>
@@ -26,8 +27,17 @@ void GeneralDataCapture::OnInspect() {
     ImGui::Checkbox("Capture image", &m_captureImage);
     ImGui::Checkbox("Capture mask", &m_captureMask);
     ImGui::Checkbox("Capture mesh", &m_captureMesh);
+    if (m_captureMesh) {
+      static const char *MeshFormats[]{"OBJ", "PLY", "GLB"};
+      ImGui::Combo("Mesh format", &m_meshFormat, MeshFormats,
+                   IM_ARRAYSIZE(MeshFormats));
+    }
     ImGui::Checkbox("Capture depth", &m_captureDepth);
     ImGui::Checkbox("Export matrices", &m_exportMatrices);
+    ImGui::DragInt("Output threads", &m_outputThreads, 1, 1, 32);
+    ImGui::Checkbox("Pack into shards", &m_packShards);
+    if (m_packShards)
+      ImGui::DragInt("Shard size (MB)", &m_shardSize, 16, 16, 1 << 16);
     ImGui::TreePop();
   }
   if (ImGui::TreeNode("Camera Settings")) {
@@ -125,11 +135,12 @@ void GeneralDataCapture::OnAfterGrowth(
             scene);
         Application::GetLayer<RayTracerLayer>()->UpdateScene();
         rayTracerCamera->Render(rayProperties);
-        rayTracerCamera->m_colorTexture->Export(
+        m_outputWriter->WriteTexture(
             m_currentExportFolder /
             GetAssetRecord().lock()->GetAssetFileName() / "Mask" /
             ("side_" + pipeline.m_prefix + "_" + std::to_string(randomTurnAngle) +
-             "_mask.png"));
+             "_mask.png"),
+            rayTracerCamera->m_colorTexture);
       } else {
         for (int turnAngle = m_turnAngleStart; turnAngle <= m_turnAngleEnd;
              turnAngle += m_turnAngleStep) {
@@ -142,11 +153,12 @@ void GeneralDataCapture::OnAfterGrowth(
               scene);
           Application::GetLayer<RayTracerLayer>()->UpdateScene();
           rayTracerCamera->Render(rayProperties);
-          rayTracerCamera->m_colorTexture->Export(
+          m_outputWriter->WriteTexture(
               m_currentExportFolder /
               GetAssetRecord().lock()->GetAssetFileName() / "Mask" /
               ("side_" + pipeline.m_prefix + "_" + std::to_string(turnAngle) +
-               "_mask.png"));
+               "_mask.png"),
+              rayTracerCamera->m_colorTexture);
         }
       }
     }
@@ -163,11 +175,12 @@ void GeneralDataCapture::OnAfterGrowth(
             scene);
         Application::GetLayer<RayTracerLayer>()->UpdateScene();
         rayTracerCamera->Render(rayProperties);
-        rayTracerCamera->m_colorTexture->Export(
+        m_outputWriter->WriteTexture(
             m_currentExportFolder /
             GetAssetRecord().lock()->GetAssetFileName() / "Mask" /
             ("top_" + pipeline.m_prefix + "_" + std::to_string(randomTurnAngle) +
-             "_mask.png"));
+             "_mask.png"),
+            rayTracerCamera->m_colorTexture);
       } else {
         for (int turnAngle = m_topTurnAngleStart;
              turnAngle <= m_topTurnAngleEnd; turnAngle += m_topTurnAngleStep) {
@@ -180,11 +193,12 @@ void GeneralDataCapture::OnAfterGrowth(
               scene);
           Application::GetLayer<RayTracerLayer>()->UpdateScene();
           rayTracerCamera->Render(rayProperties);
-          rayTracerCamera->m_colorTexture->Export(
+          m_outputWriter->WriteTexture(
               m_currentExportFolder /
               GetAssetRecord().lock()->GetAssetFileName() / "Mask" /
               ("top_" + pipeline.m_prefix + "_" + std::to_string(turnAngle) +
-               "_mask.png"));
+               "_mask.png"),
+              rayTracerCamera->m_colorTexture);
         }
       }
     }
@@ -228,11 +242,12 @@ void GeneralDataCapture::OnAfterGrowth(
             scene);
         Application::GetLayer<RayTracerLayer>()->UpdateScene();
         rayTracerCamera->Render(rayProperties);
-        rayTracerCamera->m_colorTexture->Export(
+        m_outputWriter->WriteTexture(
             m_currentExportFolder /
             GetAssetRecord().lock()->GetAssetFileName() / "Depth" /
             ("side_" + pipeline.m_prefix + "_" + std::to_string(randomTurnAngle) +
-             "_depth.hdr"));
+             "_depth.hdr"),
+            rayTracerCamera->m_colorTexture);
       } else {
         for (int turnAngle = m_turnAngleStart; turnAngle <= m_turnAngleEnd;
              turnAngle += m_turnAngleStep) {
@@ -245,11 +260,12 @@ void GeneralDataCapture::OnAfterGrowth(
               scene);
           Application::GetLayer<RayTracerLayer>()->UpdateScene();
           rayTracerCamera->Render(rayProperties);
-          rayTracerCamera->m_colorTexture->Export(
+          m_outputWriter->WriteTexture(
               m_currentExportFolder /
               GetAssetRecord().lock()->GetAssetFileName() / "Depth" /
               ("side_" + pipeline.m_prefix + "_" + std::to_string(turnAngle) +
-               "_depth.hdr"));
+               "_depth.hdr"),
+              rayTracerCamera->m_colorTexture);
         }
       }
     }
@@ -266,11 +282,12 @@ void GeneralDataCapture::OnAfterGrowth(
             scene);
         Application::GetLayer<RayTracerLayer>()->UpdateScene();
         rayTracerCamera->Render(rayProperties);
-        rayTracerCamera->m_colorTexture->Export(
+        m_outputWriter->WriteTexture(
             m_currentExportFolder /
             GetAssetRecord().lock()->GetAssetFileName() / "Depth" /
             ("top_" + pipeline.m_prefix + "_" + std::to_string(randomTurnAngle) +
-             "_depth.hdr"));
+             "_depth.hdr"),
+            rayTracerCamera->m_colorTexture);
       } else {
         for (int turnAngle = m_topTurnAngleStart;
              turnAngle <= m_topTurnAngleEnd; turnAngle += m_topTurnAngleStep) {
@@ -283,11 +300,12 @@ void GeneralDataCapture::OnAfterGrowth(
               scene);
           Application::GetLayer<RayTracerLayer>()->UpdateScene();
           rayTracerCamera->Render(rayProperties);
-          rayTracerCamera->m_colorTexture->Export(
+          m_outputWriter->WriteTexture(
               m_currentExportFolder /
               GetAssetRecord().lock()->GetAssetFileName() / "Depth" /
               ("top_" + pipeline.m_prefix + "_" + std::to_string(turnAngle) +
-               "_depth.hdr"));
+               "_depth.hdr"),
+              rayTracerCamera->m_colorTexture);
         }
       }
     }
@@ -329,11 +347,12 @@ void GeneralDataCapture::OnAfterGrowth(
             scene);
         Application::GetLayer<RayTracerLayer>()->UpdateScene();
         rayTracerCamera->Render(m_rayProperties);
-        rayTracerCamera->m_colorTexture->Export(
+        m_outputWriter->WriteTexture(
             m_currentExportFolder /
             GetAssetRecord().lock()->GetAssetFileName() / "Image" /
             ("side_" + pipeline.m_prefix + "_" + std::to_string(randomTurnAngle) +
-             "_image.png"));
+             "_image.png"),
+            rayTracerCamera->m_colorTexture);
       } else {
         for (int turnAngle = m_turnAngleStart; turnAngle <= m_turnAngleEnd;
              turnAngle += m_turnAngleStep) {
@@ -346,11 +365,12 @@ void GeneralDataCapture::OnAfterGrowth(
               scene);
           Application::GetLayer<RayTracerLayer>()->UpdateScene();
           rayTracerCamera->Render(m_rayProperties);
-          rayTracerCamera->m_colorTexture->Export(
+          m_outputWriter->WriteTexture(
               m_currentExportFolder /
               GetAssetRecord().lock()->GetAssetFileName() / "Image" /
               ("side_" + pipeline.m_prefix + "_" + std::to_string(turnAngle) +
-               "_image.png"));
+               "_image.png"),
+              rayTracerCamera->m_colorTexture);
         }
       }
     }
@@ -367,11 +387,12 @@ void GeneralDataCapture::OnAfterGrowth(
             scene);
         Application::GetLayer<RayTracerLayer>()->UpdateScene();
         rayTracerCamera->Render(m_rayProperties);
-        rayTracerCamera->m_colorTexture->Export(
+        m_outputWriter->WriteTexture(
             m_currentExportFolder /
             GetAssetRecord().lock()->GetAssetFileName() / "Image" /
             ("top_" + pipeline.m_prefix + "_" + std::to_string(randomTurnAngle) +
-             "_image.png"));
+             "_image.png"),
+            rayTracerCamera->m_colorTexture);
       } else {
         for (int turnAngle = m_topTurnAngleStart;
              turnAngle <= m_topTurnAngleEnd; turnAngle += m_topTurnAngleStep) {
@@ -384,21 +405,49 @@ void GeneralDataCapture::OnAfterGrowth(
               scene);
           Application::GetLayer<RayTracerLayer>()->UpdateScene();
           rayTracerCamera->Render(m_rayProperties);
-          rayTracerCamera->m_colorTexture->Export(
+          m_outputWriter->WriteTexture(
               m_currentExportFolder /
               GetAssetRecord().lock()->GetAssetFileName() / "Image" /
               ("top_" + pipeline.m_prefix + "_" + std::to_string(turnAngle) +
-               "_image.png"));
+               "_image.png"),
+              rayTracerCamera->m_colorTexture);
         }
       }
     }
   }
   if (m_captureMesh) {
     sorghumData->SetEnableSegmentedMask(false);
-    sorghumData->ExportModel(
-        (m_currentExportFolder / GetAssetRecord().lock()->GetAssetFileName() /
-         "Mesh" / (pipeline.m_prefix + ".obj"))
-            .string());
+    const auto meshFolder = m_currentExportFolder /
+                            GetAssetRecord().lock()->GetAssetFileName() /
+                            "Mesh";
+    // Geometry is copied or formatted here, encoding and writing happen on the output writer.
+    if (m_meshFormat == 1 || m_meshFormat == 2) {
+      const auto format = m_meshFormat == 1 ? SorghumMeshFormat::Ply
+                                            : SorghumMeshFormat::Glb;
+      const auto path = meshFolder / (pipeline.m_prefix +
+                                      (m_meshFormat == 1 ? ".ply" : ".glb"));
+      auto plantMesh = std::make_shared<SorghumPlantMesh>();
+      plantMesh->Collect(scene, pipeline.m_currentGrowingSorghum);
+      plantMesh->MakeOwned();
+      // Encoded in memory, so packed runs append it to the shards without touching the disk.
+      m_outputWriter->Submit(
+          [plantMesh, path, format, outputWriter = m_outputWriter.get()]() {
+            SorghumMeshWriter writer;
+            writer.Open(format);
+            writer.Write(*plantMesh);
+            if (!writer.Close())
+              return false;
+            const auto data = writer.TakeData();
+            return outputWriter->Commit(path, data.data(), data.size());
+          });
+    } else {
+      std::string buffer = "#Sorghum field, by Bosheng Li\n";
+      unsigned startIndex = 1;
+      SorghumLayer::ExportSorghum(pipeline.m_currentGrowingSorghum, buffer,
+                                  startIndex);
+      m_outputWriter->WriteFile(meshFolder / (pipeline.m_prefix + ".obj"),
+                                std::move(buffer));
+    }
   }
 
   if ((m_captureImage || m_captureMask || m_captureDepth) && m_exportMatrices) {
@@ -475,6 +524,10 @@ void GeneralDataCapture::Serialize(YAML::Emitter &out) {
   out << YAML::Key << "m_captureImage" << YAML::Value << m_captureImage;
   out << YAML::Key << "m_captureMask" << YAML::Value << m_captureMask;
   out << YAML::Key << "m_captureMesh" << YAML::Value << m_captureMesh;
+  out << YAML::Key << "m_meshFormat" << YAML::Value << m_meshFormat;
+  out << YAML::Key << "m_outputThreads" << YAML::Value << m_outputThreads;
+  out << YAML::Key << "m_packShards" << YAML::Value << m_packShards;
+  out << YAML::Key << "m_shardSize" << YAML::Value << m_shardSize;
   out << YAML::Key << "m_exportMatrices" << YAML::Value << m_exportMatrices;
   out << YAML::Key << "m_currentExportFolder" << YAML::Value
       << m_currentExportFolder.string();
@@ -519,6 +572,14 @@ void GeneralDataCapture::Deserialize(const YAML::Node &in) {
     m_captureMask = in["m_captureMask"].as<bool>();
   if (in["m_captureMesh"])
     m_captureMesh = in["m_captureMesh"].as<bool>();
+  if (in["m_meshFormat"])
+    m_meshFormat = in["m_meshFormat"].as<int>();
+  if (in["m_outputThreads"])
+    m_outputThreads = in["m_outputThreads"].as<int>();
+  if (in["m_packShards"])
+    m_packShards = in["m_packShards"].as<bool>();
+  if (in["m_shardSize"])
+    m_shardSize = in["m_shardSize"].as<int>();
   if (in["m_exportMatrices"])
     m_exportMatrices = in["m_exportMatrices"].as<bool>();
 
@@ -596,24 +657,35 @@ void GeneralDataCapture::OnStart(AutoSorghumGenerationPipeline &pipeline) {
   rayTracerCamera->SetMainCamera(true);
 
   m_sorghumInfos.clear();
+  m_outputWriter = std::make_shared<AsyncOutputWriter>(m_outputThreads);
   std::filesystem::create_directories(
       m_currentExportFolder / GetAssetRecord().lock()->GetAssetFileName());
-  if (m_captureImage) {
+  if (m_packShards) {
+    const auto root =
+        m_currentExportFolder / GetAssetRecord().lock()->GetAssetFileName();
+    m_shardWriter = std::make_shared<DatasetShardWriter>();
+    if (m_shardWriter->Open(root, (size_t)m_shardSize * 1024 * 1024))
+      m_outputWriter->SetShardWriter(m_shardWriter, root);
+    else
+      m_shardWriter.reset();
+  }
+  // Packed outputs go straight into the shards, only loose files need their folders.
+  if (m_captureImage && !m_shardWriter) {
     std::filesystem::create_directories(
         m_currentExportFolder / GetAssetRecord().lock()->GetAssetFileName() /
         "Image");
   }
-  if (m_captureMask) {
+  if (m_captureMask && !m_shardWriter) {
     std::filesystem::create_directories(
         m_currentExportFolder / GetAssetRecord().lock()->GetAssetFileName() /
         "Mask");
   }
-  if (m_captureMesh) {
+  if (m_captureMesh && !m_shardWriter) {
     std::filesystem::create_directories(
         m_currentExportFolder / GetAssetRecord().lock()->GetAssetFileName() /
         "Mesh");
   }
-  if (m_captureDepth) {
+  if (m_captureDepth && !m_shardWriter) {
     std::filesystem::create_directories(
         m_currentExportFolder / GetAssetRecord().lock()->GetAssetFileName() /
         "Depth");
@@ -626,15 +698,44 @@ void GeneralDataCapture::OnEnd(AutoSorghumGenerationPipeline &pipeline) {
   if (scene->IsEntityValid(m_dirt))
     scene->DeleteEntity(m_dirt);
 
-  if ((m_captureImage || m_captureMask || m_captureDepth) && m_exportMatrices)
+  if (m_outputWriter) {
+    if (const int failed = m_outputWriter->Flush())
+      UNIENGINE_ERROR(std::to_string(failed) + " outputs failed to write!");
+    m_outputWriter.reset();
+  }
+  if (m_shardWriter) {
+    m_shardWriter->Close();
+    ExportManifest(m_currentExportFolder /
+                   GetAssetRecord().lock()->GetAssetFileName() /
+                   "manifest.yml");
+    m_shardWriter.reset();
+  } else if ((m_captureImage || m_captureMask || m_captureDepth) &&
+             m_exportMatrices)
     ExportMatrices(m_currentExportFolder /
                    GetAssetRecord().lock()->GetAssetFileName() /
                    "matrices.yml");
 }
 
-void GeneralDataCapture::ExportMatrices(const std::filesystem::path &path) {
+void GeneralDataCapture::ExportManifest(const std::filesystem::path &path) {
   YAML::Emitter out;
   out << YAML::BeginMap;
+  out << YAML::Key << "Index" << YAML::Value << "index.csv";
+  out << YAML::Key << "Shards" << YAML::Value << YAML::BeginSeq;
+  for (int i = 0; i < m_shardWriter->GetShardAmount(); i++)
+    out << DatasetShardWriter::GetShardName(i);
+  out << YAML::EndSeq;
+  out << YAML::Key << "Max Shard Size" << YAML::Value
+      << m_shardWriter->GetMaxShardSize();
+  out << YAML::Key << "Entry Amount" << YAML::Value
+      << m_shardWriter->GetEntryAmount();
+  EmitCaptureInfo(out);
+  out << YAML::EndMap;
+  std::ofstream fout(path.string());
+  fout << out.c_str();
+  fout.flush();
+}
+
+void GeneralDataCapture::EmitCaptureInfo(YAML::Emitter &out) const {
   out << YAML::Key << "Capture Info" << YAML::BeginSeq;
   for (int i = 0; i < m_projections.size(); i++) {
     out << YAML::BeginMap;
@@ -646,6 +747,12 @@ void GeneralDataCapture::ExportMatrices(const std::filesystem::path &path) {
     out << YAML::EndMap;
   }
   out << YAML::EndSeq;
+}
+
+void GeneralDataCapture::ExportMatrices(const std::filesystem::path &path) {
+  YAML::Emitter out;
+  out << YAML::BeginMap;
+  EmitCaptureInfo(out);
   out << YAML::EndMap;
   std::ofstream fout(path.string());
   fout << out.c_str();
@@ -8,6 +8,17 @@
 #include "SkyIlluminance.hpp"
 #include "SorghumStateGenerator.hpp"
 using namespace Scripts;
+
+static float AverageSensorEnergy(PARSensorGroup &sensorGroup,
+                                 const RayProperties &rayProperties) {
+  sensorGroup.CalculateIllumination(rayProperties, 0, 0.0f);
+  float sum = 0;
+  for (const auto &i : sensorGroup.m_samplers) {
+    sum += i.m_energy;
+  }
+  return sum / sensorGroup.m_samplers.size();
+}
+
 void IlluminationEstimationPipeline::OnInspect() {
   if(ImGui::Button("Instantiate pipeline")){
     Instantiate();
@@ -31,7 +42,12 @@ void IlluminationEstimationPipeline::OnInspect() {
   Editor::DragAndDropButton<SkyIlluminance>(m_skyIlluminance,
                                             "Sky Illuminance");
   m_rayProperties.OnInspect();
-  ImGui::DragFloat("Interval", &m_timeInterval, 0.1f, 0.01f, 100.0f);
+  ImGui::Checkbox("Integrate by sun direction", &m_binnedIntegration);
+  if (m_binnedIntegration) {
+    ImGui::DragFloat2("Integration window", &m_integrationWindow.x);
+  } else {
+    ImGui::DragFloat("Interval", &m_timeInterval, 0.1f, 0.01f, 100.0f);
+  }
 
 
   static AssetRef dropSlot;
@@ -85,9 +101,21 @@ void IlluminationEstimationPipeline::OnInspect() {
 }
 void IlluminationEstimationPipeline::OnBeforeProcessing(
     GeneralAutomatedPipeline &pipeline) {
+  m_currentTime = 0;
+  m_currentBin = 0;
+  m_bins.clear();
+  auto skyIlluminance = m_skyIlluminance.Get<SkyIlluminance>();
+  if (m_binnedIntegration && skyIlluminance) {
+    skyIlluminance->GetSunDirectionHistogram(
+        m_integrationWindow.x, m_integrationWindow.y, m_bins);
+    m_results.emplace_back(m_integrationWindow.y,
+                           std::vector<float>(m_sensorGroups.size(), 0.0f));
+  }
+  pipeline.m_status = GeneralAutomatedPipelineStatus::Processing;
 }
 void IlluminationEstimationPipeline::OnAfterProcessing(
     GeneralAutomatedPipeline &pipeline) {
+  pipeline.m_status = GeneralAutomatedPipelineStatus::Idle;
 }
 void IlluminationEstimationPipeline::OnProcessing(
     GeneralAutomatedPipeline &pipeline) {
@@ -97,29 +125,42 @@ void IlluminationEstimationPipeline::OnProcessing(
     pipeline.m_status = GeneralAutomatedPipelineStatus::Idle;
     return;
   }
+  auto &environmentProperties =
+      Application::GetLayer<RayTracerLayer>()->m_environmentProperties;
+  if (m_binnedIntegration) {
+    if (m_currentBin >= m_bins.size()) {
+      pipeline.m_status = GeneralAutomatedPipelineStatus::AfterProcessing;
+      return;
+    }
+    const auto &bin = m_bins[m_currentBin];
+    environmentProperties.m_sunDirection = bin.m_direction;
+    environmentProperties.m_skylightIntensity = 1.0f;
+    auto &integrals = m_results.back().second;
+    for (int i = 0; i < m_sensorGroups.size(); i++) {
+      auto sensorGroup = m_sensorGroups[i].Get<PARSensorGroup>();
+      if (sensorGroup && !sensorGroup->m_samplers.empty()) {
+        integrals[i] +=
+            AverageSensorEnergy(*sensorGroup, m_rayProperties) * bin.m_energy;
+      }
+    }
+    m_currentBin++;
+    return;
+  }
   if (m_currentTime > skyIlluminance->m_maxTime) {
     m_currentTime = 0;
+    pipeline.m_status = GeneralAutomatedPipelineStatus::AfterProcessing;
     return;
   }
   auto snapshot = skyIlluminance->Get(m_currentTime);
-  Application::GetLayer<RayTracerLayer>()
-      ->m_environmentProperties.m_sunDirection = snapshot.GetSunDirection();
-
-  Application::GetLayer<RayTracerLayer>()
-      ->m_environmentProperties.m_skylightIntensity =
-      snapshot.GetSunIntensity();
+  environmentProperties.m_sunDirection = snapshot.GetSunDirection();
+  environmentProperties.m_skylightIntensity = snapshot.GetSunIntensity();
 
   m_results.emplace_back(m_currentTime, std::vector<float>());
   for (auto sensorGroupRef : m_sensorGroups) {
     auto sensorGroup = sensorGroupRef.Get<PARSensorGroup>();
     if (sensorGroup && !sensorGroup->m_samplers.empty()) {
-      sensorGroup->CalculateIllumination(m_rayProperties, 0, 0.0f);
-      float sum = 0;
-      for (const auto &i : sensorGroup->m_samplers) {
-        sum += i.m_energy;
-      }
-      sum /= sensorGroup->m_samplers.size();
-      m_results.back().second.push_back(sum);
+      m_results.back().second.push_back(
+          AverageSensorEnergy(*sensorGroup, m_rayProperties));
     }
   }
   m_currentTime += m_timeInterval;
@@ -132,6 +173,10 @@ void IlluminationEstimationPipeline::CollectAssetRef(
 }
 void IlluminationEstimationPipeline::Serialize(YAML::Emitter &out) {
   out << YAML::Key << "m_timeInterval" << YAML::Value << m_timeInterval;
+  out << YAML::Key << "m_binnedIntegration" << YAML::Value
+      << m_binnedIntegration;
+  out << YAML::Key << "m_integrationWindow" << YAML::Value
+      << m_integrationWindow;
   out << YAML::Key << "m_rayProperties.m_bounces" << YAML::Value
       << m_rayProperties.m_bounces;
   out << YAML::Key << "m_rayProperties.m_samples" << YAML::Value
@@ -150,6 +195,10 @@ void IlluminationEstimationPipeline::Serialize(YAML::Emitter &out) {
 }
 void IlluminationEstimationPipeline::Deserialize(const YAML::Node &in) {
   m_timeInterval = in["m_timeInterval"].as<float>();
+  if (in["m_binnedIntegration"])
+    m_binnedIntegration = in["m_binnedIntegration"].as<bool>();
+  if (in["m_integrationWindow"])
+    m_integrationWindow = in["m_integrationWindow"].as<glm::vec2>();
   m_rayProperties.m_bounces = in["m_rayProperties.m_bounces"].as<int>();
   m_rayProperties.m_samples = in["m_rayProperties.m_samples"].as<int>();
   m_skyIlluminance.Load("m_skyIlluminance", in);
@@ -6,6 +6,7 @@
 #include "LeafData.hpp"
 #include "Tinyply.hpp"
 #include "StemData.hpp"
+#include "TransformLayer.hpp"
 #ifdef RAYTRACERFACILITY
 #include "PARSensorGroup.hpp"
 #include "RayTracerLayer.hpp"
@@ -31,7 +32,8 @@ void PointCloudCapture::OnBeforeGrowth(
 	positionField->m_seperated = true;
 	m_ground = m_fieldGround.Get<FieldGround>()->GenerateMesh(glm::linearRand(0.12f, 0.17f));
 	Transform fieldGroundTransform;
-	fieldGroundTransform.SetPosition(glm::vec3(0, glm::linearRand(0.0f, 0.15f), 0));
+	const float groundHeight = glm::linearRand(0.0f, 0.15f);
+	fieldGroundTransform.SetPosition(glm::vec3(0, groundHeight, 0));
 	scene->SetDataComponent(m_ground, fieldGroundTransform);
 	auto result = positionsField->InstantiateAroundIndex(
 		pipeline.GetSeed() % positionsField->m_positions.size(), 2.5f, m_currentCenter, m_settings.m_positionVariance);
@@ -43,8 +45,26 @@ void PointCloudCapture::OnBeforeGrowth(
 		UNIENGINE_ERROR("Invalid sorghum/field");
 		return;
 	}
+	if (m_settings.m_snapToGround) SnapFieldToGround(scene, groundHeight);
 	pipeline.m_status = AutoSorghumGenerationPipelineStatus::Growth;
 }
+void PointCloudCapture::SnapFieldToGround(const std::shared_ptr<Scene>& scene, float groundHeight) const {
+	auto fieldGround = m_fieldGround.Get<FieldGround>();
+	auto sorghums = scene->GetChildren(m_currentSorghumField);
+	std::vector<glm::vec2> positions(sorghums.size());
+	for (int i = 0; i < sorghums.size(); i++) {
+		const auto position = scene->GetDataComponent<Transform>(sorghums[i]).GetPosition();
+		positions[i] = glm::vec2(position.x, position.z);
+	}
+	std::vector<float> heights;
+	fieldGround->SampleHeights(positions, heights);
+	for (int i = 0; i < sorghums.size(); i++) {
+		auto transform = scene->GetDataComponent<Transform>(sorghums[i]);
+		transform.m_value[3].y = heights[i] + groundHeight;
+		scene->SetDataComponent(sorghums[i], transform);
+	}
+	Application::GetLayer<TransformLayer>()->CalculateTransformGraphForDescendents(scene, m_currentSorghumField);
+}
 void PointCloudCapture::OnGrowth(AutoSorghumGenerationPipeline& pipeline) {
 	pipeline.m_status = AutoSorghumGenerationPipelineStatus::AfterGrowth;
 }
@@ -57,7 +77,7 @@ void PointCloudCapture::OnAfterGrowth(AutoSorghumGenerationPipeline& pipeline) {
 	ExportCSV(
 		pipeline,
 		m_currentExportFolder / GetAssetRecord().lock()->GetAssetFileName() /
-		"CSV" / (pipeline.m_prefix + std::string(".csv")));
+		"CSV" / (pipeline.m_prefix + std::string(".csv")), m_outputWriter);
 
 	auto scene = pipeline.GetScene();
 	scene->DeleteEntity(m_currentSorghumField);
@@ -86,6 +106,7 @@ void PointCloudCapture::OnInspect() {
 
 	Editor::DragAndDropButton<PositionsField>(m_positionsField, "Position Field");
 	Editor::DragAndDropButton<FieldGround>(m_fieldGround, "Field Ground");
+	ImGui::DragInt("Output threads", &m_outputThreads, 1, 1, 32);
 	m_settings.OnInspect();
 }
 
@@ -96,6 +117,7 @@ void PointCloudCapture::OnStart(AutoSorghumGenerationPipeline& pipeline) {
 	std::filesystem::create_directories(
 		m_currentExportFolder / GetAssetRecord().lock()->GetAssetFileName() /
 		"CSV");
+	m_outputWriter = std::make_shared<AsyncOutputWriter>(m_outputThreads);
 	auto scene = pipeline.GetScene();
 
 
@@ -105,8 +127,11 @@ void PointCloudCapture::OnEnd(AutoSorghumGenerationPipeline& pipeline) {
 	if (scene->IsEntityValid(m_currentSorghumField))
 		scene->DeleteEntity(m_currentSorghumField);
 	pipeline.m_currentGrowingSorghum = m_currentSorghumField = {};
-
-
+	if (m_outputWriter) {
+		if (const int failed = m_outputWriter->Flush())
+			UNIENGINE_ERROR(std::to_string(failed) + " outputs failed to write!");
+		m_outputWriter.reset();
+	}
 }
 void PointCloudCapture::Reset(AutoSorghumGenerationPipeline& pipeline) {
 	auto scene = pipeline.GetScene();
@@ -133,6 +158,7 @@ void PointCloudCapture::Serialize(YAML::Emitter& out) {
 	m_fieldGround.Save("m_fieldGround", out);
 	out << YAML::Key << "m_currentExportFolder" << YAML::Value
 		<< m_currentExportFolder.string();
+	out << YAML::Key << "m_outputThreads" << YAML::Value << m_outputThreads;
 	m_settings.Serialize("m_settings", out);
 }
 void PointCloudCapture::Deserialize(const YAML::Node& in) {
@@ -140,6 +166,8 @@ void PointCloudCapture::Deserialize(const YAML::Node& in) {
 	m_fieldGround.Load("m_fieldGround", in);
 	if (in["m_currentExportFolder"])
 		m_currentExportFolder = in["m_currentExportFolder"].as<std::string>();
+	if (in["m_outputThreads"])
+		m_outputThreads = in["m_outputThreads"].as<int>();
 	m_settings.Deserialize("m_settings", in);
 }
 
@@ -161,6 +189,8 @@ void PointCloudSampleSettings::OnInspect() {
 		ImGui::DragFloat("Scanner radius", &m_scannerBoundingBoxRadius, 0.01f);
 	}
 	ImGui::DragFloat("Position Variance", &m_positionVariance);
+	ImGui::Checkbox("Snap to ground", &m_snapToGround);
+	ImGui::Checkbox("Compact output", &m_compactOutput);
 }
 void PointCloudSampleSettings::Serialize(const std::string& name,
 	YAML::Emitter& out) const {
@@ -179,6 +209,8 @@ void PointCloudSampleSettings::Serialize(const std::string& name,
 	out << YAML::Key << "m_segmentAmount" << YAML::Value << m_segmentAmount;
 
 	out << YAML::Key << "m_positionVariance" << YAML::Value << m_positionVariance;
+	out << YAML::Key << "m_snapToGround" << YAML::Value << m_snapToGround;
+	out << YAML::Key << "m_compactOutput" << YAML::Value << m_compactOutput;
 	out << YAML::EndMap;
 }
 void PointCloudSampleSettings::Deserialize(const std::string& name,
@@ -204,6 +236,10 @@ void PointCloudSampleSettings::Deserialize(const std::string& name,
 
 		if (cd["m_positionVariance"])
 			m_positionVariance = cd["m_positionVariance"].as<float>();
+		if (cd["m_snapToGround"])
+			m_snapToGround = cd["m_snapToGround"].as<bool>();
+		if (cd["m_compactOutput"])
+			m_compactOutput = cd["m_compactOutput"].as<bool>();
 	}
 }
 
@@ -467,20 +503,6 @@ void PointCloudCapture::ScanPointCloudLabeled(
 	for (const auto& i : results3)
 		i.wait();
 
-	std::filebuf fb_binary;
-	fb_binary.open(savePath.string(), std::ios::out | std::ios::binary);
-	std::ostream outstream_binary(&fb_binary);
-	if (outstream_binary.fail())
-		throw std::runtime_error("failed to open " + savePath.string());
-	/*
-	std::filebuf fb_ascii;
-	fb_ascii.open(filename + "-ascii.ply", std::ios::out);
-	std::ostream outstream_ascii(&fb_ascii);
-	if (outstream_ascii.fail()) throw std::runtime_error("failed to open " +
-	filename);
-	*/
-
-
 	std::vector<std::shared_future<void>> results4;
 	Jobs::ParallelFor(
 		points.size(),
@@ -492,6 +514,42 @@ void PointCloudCapture::ScanPointCloudLabeled(
 	for (const auto& i : results4)
 		i.wait();
 
+	//The labeled cloud is handed over to the output writer, the pipeline moves on to the next plant.
+	auto write = [savePath, compact = settings.m_compactOutput, points = std::move(points), colors = std::move(colors),
+		leafIndex = std::move(leafIndex), leafPartIndex = std::move(leafPartIndex), isMainPlant = std::move(isMainPlant),
+		plantIndex = std::move(plantIndex), isGround = std::move(isGround)]() mutable {
+		if (compact)
+			return WriteCompactPly(savePath, points, colors, leafIndex, leafPartIndex, isMainPlant, plantIndex, isGround);
+		return WritePly(savePath, points, colors, leafIndex, leafPartIndex, isMainPlant, plantIndex, isGround);
+	};
+	if (m_outputWriter)
+		m_outputWriter->Submit(std::move(write));
+	else
+		write();
+#else
+	UNIENGINE_ERROR("Ray tracer disabled!");
+#endif
+}
+bool PointCloudCapture::WritePly(const std::filesystem::path& path,
+	std::vector<glm::dvec3>& points, std::vector<glm::vec3>& colors,
+	std::vector<int>& leafIndex, std::vector<int>& leafPartIndex,
+	std::vector<int>& isMainPlant, std::vector<int>& plantIndex,
+	std::vector<int>& isGround) {
+	std::filebuf fb_binary;
+	fb_binary.open(path.string(), std::ios::out | std::ios::binary);
+	std::ostream outstream_binary(&fb_binary);
+	if (outstream_binary.fail()) {
+		UNIENGINE_ERROR("failed to open " + path.string());
+		return false;
+	}
+	/*
+	std::filebuf fb_ascii;
+	fb_ascii.open(filename + "-ascii.ply", std::ios::out);
+	std::ostream outstream_ascii(&fb_ascii);
+	if (outstream_ascii.fail()) throw std::runtime_error("failed to open " +
+	filename);
+	*/
+
 	PlyFile cube_file;
 
 
@@ -518,17 +576,70 @@ void PointCloudCapture::ScanPointCloudLabeled(
 		reinterpret_cast<uint8_t*>(isGround.data()), Type::INVALID, 0);
 	// Write a binary file
 	cube_file.write(outstream_binary, true);
-#else
-	UNIENGINE_ERROR("Ray tracer disabled!");
-#endif
+	return true;
+}
+//Maps [0, 1] to [0, 255], NaN becomes 0.
+static unsigned char ColorToByte(const float value) {
+	if (!(value > 0.0f)) return 0;
+	return static_cast<unsigned char>(glm::round(glm::min(value, 1.0f) * 255.0f));
+}
+bool PointCloudCapture::WriteCompactPly(const std::filesystem::path& path,
+	const std::vector<glm::dvec3>& points, const std::vector<glm::vec3>& colors,
+	const std::vector<int>& leafIndex, const std::vector<int>& leafPartIndex,
+	const std::vector<int>& isMainPlant, const std::vector<int>& plantIndex,
+	const std::vector<int>& isGround) {
+	std::ofstream of(path, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+	if (!of.is_open()) {
+		UNIENGINE_ERROR("Can't open file!");
+		return false;
+	}
+	//Positions are stored as float relative to the minimum corner, which keeps sub millimeter precision
+	//even when the field center is far from the origin.
+	glm::dvec3 offset = glm::dvec3(0.0);
+	if (!points.empty()) {
+		offset = points[0];
+		for (const auto& point : points) offset = glm::min(offset, point);
+	}
+	char offsetText[128];
+	snprintf(offsetText, sizeof(offsetText), "comment offset %.17g %.17g %.17g\n", offset.x, offset.y, offset.z);
+	const std::string header = std::string("ply\nformat binary_little_endian 1.0\n") + offsetText +
+		"element vertex " + std::to_string(points.size()) + "\n"
+		"property float x\nproperty float y\nproperty float z\n"
+		"property uchar red\nproperty uchar green\nproperty uchar blue\n"
+		"property uchar leaf_index\nproperty uchar leaf_part_index\n"
+		"property uchar is_main_plant\nproperty ushort plant_index\nproperty uchar is_ground\n"
+		"end_header\n";
+	of.write(header.data(), header.size());
+
+	//x, y, z, rgb, leaf index, leaf part, main plant, plant index, ground.
+	constexpr size_t stride = 12 + 3 + 3 + 2 + 1;
+	constexpr size_t chunkSize = 1 << 16;
+	std::vector<char> buffer(glm::min(points.size(), chunkSize) * stride);
+	for (size_t chunkStart = 0; chunkStart < points.size(); chunkStart += chunkSize) {
+		const size_t chunkEnd = glm::min(points.size(), chunkStart + chunkSize);
+		char* data = buffer.data();
+		for (size_t i = chunkStart; i < chunkEnd; i++) {
+			const glm::vec3 position = glm::vec3(points[i] - offset);
+			std::memcpy(data, &position, 12);
+			data[12] = ColorToByte(colors[i].x);
+			data[13] = ColorToByte(colors[i].y);
+			data[14] = ColorToByte(colors[i].z);
+			data[15] = static_cast<unsigned char>(glm::clamp(leafIndex[i], 0, 255));
+			data[16] = static_cast<unsigned char>(glm::clamp(leafPartIndex[i], 0, 255));
+			data[17] = static_cast<unsigned char>(glm::clamp(isMainPlant[i], 0, 255));
+			const auto plant = static_cast<unsigned short>(glm::clamp(plantIndex[i], 0, 65535));
+			std::memcpy(data + 18, &plant, 2);
+			data[20] = static_cast<unsigned char>(glm::clamp(isGround[i], 0, 255));
+			data += stride;
+		}
+		of.write(buffer.data(), data - buffer.data());
+	}
+	return of.good();
 }
 void PointCloudCapture::ExportCSV(AutoSorghumGenerationPipeline& pipeline,
-	const std::filesystem::path& path) {
-	auto scene = pipeline.GetScene();
-	std::ofstream ofs;
-	ofs.open(path.c_str(), std::ofstream::out | std::ofstream::trunc);
-	if (ofs.is_open()) {
-		std::string output;
+	const std::filesystem::path& path, const std::shared_ptr<AsyncOutputWriter>& outputWriter) {
+	std::string output;
+	{
 		auto scene = pipeline.GetScene();
 		std::map<int, std::shared_ptr<LeafData>> leafDataList;
 		auto children = scene->GetChildren(pipeline.m_currentGrowingSorghum);
@@ -553,7 +664,14 @@ void PointCloudCapture::ExportCSV(AutoSorghumGenerationPipeline& pipeline,
 			output += std::to_string(i.second->m_branchingAngle) + ",";
 			output += std::to_string(i.second->m_rollAngle) + "\n";
 		}
-
+	}
+	if (outputWriter) {
+		outputWriter->WriteFile(path, std::move(output));
+		return;
+	}
+	std::ofstream ofs;
+	ofs.open(path.c_str(), std::ofstream::out | std::ofstream::trunc);
+	if (ofs.is_open()) {
 		ofs.write(output.c_str(), output.size());
 		ofs.flush();
 		ofs.close();
@@ -0,0 +1,165 @@
+#include "AsyncOutputWriter.hpp"
+#include <stb_image_write.h>
+
+using namespace EcoSysLab;
+
+AsyncOutputWriter::AsyncOutputWriter(int workerAmount, size_t capacity) {
+  m_capacity = glm::max(capacity, (size_t)1);
+  for (int i = 0; i < glm::max(workerAmount, 1); i++) {
+    m_workers.emplace_back([this]() { Work(); });
+  }
+}
+
+AsyncOutputWriter::~AsyncOutputWriter() {
+  Flush();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_taskAvailable.notify_all();
+  for (auto &worker : m_workers)
+    worker.join();
+}
+
+void AsyncOutputWriter::Work() {
+  while (true) {
+    std::function<bool()> task;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_taskAvailable.wait(lock, [&]() { return m_stop || !m_tasks.empty(); });
+      if (m_tasks.empty())
+        return;
+      task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+    }
+    m_slotAvailable.notify_one();
+    bool succeed = false;
+    try {
+      succeed = task();
+    } catch (const std::exception &e) {
+      UNIENGINE_ERROR(std::string("Output failed: ") + e.what());
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (!succeed)
+        m_failed++;
+      m_pending--;
+    }
+    m_idle.notify_all();
+  }
+}
+
+void AsyncOutputWriter::Submit(std::function<bool()> &&task) {
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_slotAvailable.wait(lock, [&]() { return m_tasks.size() < m_capacity; });
+    m_tasks.push_back(std::move(task));
+    m_pending++;
+  }
+  m_taskAvailable.notify_one();
+}
+
+void AsyncOutputWriter::SetShardWriter(
+    const std::shared_ptr<DatasetShardWriter> &shardWriter,
+    const std::filesystem::path &root) {
+  m_shardWriter = shardWriter;
+  m_shardRoot = root;
+}
+
+bool AsyncOutputWriter::Commit(const std::filesystem::path &path,
+                               const void *data, size_t size) {
+  if (m_shardWriter) {
+    auto type = path.extension().string();
+    if (!type.empty())
+      type = type.substr(1);
+    return m_shardWriter->Append(
+        path.lexically_relative(m_shardRoot).generic_string(), type, data,
+        size);
+  }
+  std::ofstream of(path, std::ofstream::out | std::ofstream::binary |
+                             std::ofstream::trunc);
+  if (!of.is_open()) {
+    UNIENGINE_ERROR("Can't open file " + path.string());
+    return false;
+  }
+  of.write(static_cast<const char *>(data), size);
+  return of.good();
+}
+
+void AsyncOutputWriter::WriteFile(const std::filesystem::path &path,
+                                  std::string &&data) {
+  Submit([this, path, data = std::move(data)]() {
+    return Commit(path, data.data(), data.size());
+  });
+}
+
+inline void AppendEncoded(void *context, void *data, int size) {
+  auto &encoded = *static_cast<std::vector<unsigned char> *>(context);
+  encoded.insert(encoded.end(), static_cast<unsigned char *>(data),
+                 static_cast<unsigned char *>(data) + size);
+}
+
+void AsyncOutputWriter::WriteImage(const std::filesystem::path &path,
+                                   int width, int height,
+                                   std::vector<float> &&pixels) {
+  Submit([this, path, width, height, pixels = std::move(pixels)]() {
+    if (pixels.size() < (size_t)width * height * 4)
+      return false;
+    const auto extension = path.extension().string();
+    std::vector<unsigned char> encoded;
+    // Rows are flipped here instead of through the global stbi flag, which other threads may use.
+    if (extension == ".hdr") {
+      std::vector<float> rgb((size_t)width * height * 3);
+      for (int y = 0; y < height; y++) {
+        const float *source = &pixels[(size_t)(height - 1 - y) * width * 4];
+        float *target = &rgb[(size_t)y * width * 3];
+        for (int x = 0; x < width; x++) {
+          target[x * 3] = source[x * 4];
+          target[x * 3 + 1] = source[x * 4 + 1];
+          target[x * 3 + 2] = source[x * 4 + 2];
+        }
+      }
+      if (!stbi_write_hdr_to_func(AppendEncoded, &encoded, width, height, 3,
+                                  rgb.data()))
+        return false;
+    } else {
+      std::vector<unsigned char> rgb((size_t)width * height * 3);
+      for (int y = 0; y < height; y++) {
+        const float *source = &pixels[(size_t)(height - 1 - y) * width * 4];
+        unsigned char *target = &rgb[(size_t)y * width * 3];
+        for (int x = 0; x < width * 3; x++) {
+          target[x] = static_cast<unsigned char>(
+              glm::clamp(source[x / 3 * 4 + x % 3], 0.0f, 1.0f) * 255.0f);
+        }
+      }
+      const bool succeed =
+          extension == ".jpg" || extension == ".jpeg"
+              ? stbi_write_jpg_to_func(AppendEncoded, &encoded, width, height,
+                                       3, rgb.data(), 100)
+              : stbi_write_png_to_func(AppendEncoded, &encoded, width, height,
+                                       3, rgb.data(), width * 3);
+      if (!succeed)
+        return false;
+    }
+    return Commit(path, encoded.data(), encoded.size());
+  });
+}
+
+void AsyncOutputWriter::WriteTexture(const std::filesystem::path &path,
+                                     const std::shared_ptr<Texture2D> &texture) {
+  if (!texture)
+    return;
+  const auto resolution = glm::ivec2(texture->GetResolution());
+  std::vector<float> pixels((size_t)resolution.x * resolution.y * 4);
+  texture->UnsafeGetGLTexture()->Bind(0);
+  glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, pixels.data());
+  WriteImage(path, resolution.x, resolution.y, std::move(pixels));
+}
+
+int AsyncOutputWriter::Flush() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_idle.wait(lock, [&]() { return m_pending == 0; });
+  const int failed = m_failed;
+  m_failed = 0;
+  return failed;
+}
@@ -0,0 +1,80 @@
+#include "AsyncTextureLoader.hpp"
+#include <stb_image.h>
+
+using namespace EcoSysLab;
+
+void AsyncTextureLoader::Load(
+    const std::filesystem::path &path,
+    const std::shared_ptr<Texture2D> &texture,
+    std::function<void(const std::shared_ptr<Texture2D> &)> &&onLoaded) {
+  Task task;
+  task.m_texture = texture;
+  task.m_onLoaded = std::move(onLoaded);
+  task.m_path = path;
+  task.m_pixels = std::async(std::launch::async, [path]() {
+    std::pair<glm::uvec2, std::vector<glm::vec4>> result;
+    int width, height, channels;
+    // 8 bit decode keeps the stored values, stbi_loadf would apply its global LDR gamma.
+    // Rows are flipped here instead of through the global stbi flag, which other threads may use.
+    unsigned char *data = stbi_load(path.string().c_str(), &width, &height,
+                                    &channels, STBI_rgb_alpha);
+    if (!data)
+      return result;
+    result.first = glm::uvec2(width, height);
+    result.second.resize((size_t)width * height);
+    for (int y = 0; y < height; y++) {
+      const unsigned char *row = data + (size_t)(height - 1 - y) * width * 4;
+      for (int x = 0; x < width; x++) {
+        result.second[(size_t)y * width + x] =
+            glm::vec4(row[x * 4], row[x * 4 + 1], row[x * 4 + 2],
+                      row[x * 4 + 3]) /
+            255.0f;
+      }
+    }
+    stbi_image_free(data);
+    return result;
+  });
+  m_tasks.emplace_back(std::move(task));
+}
+
+void AsyncTextureLoader::Finish(Task &task) {
+  auto pixels = task.m_pixels.get();
+  if (pixels.second.empty()) {
+    UNIENGINE_ERROR("Can't load texture " + task.m_path.string());
+    return;
+  }
+  task.m_texture->SetRgbaChannelData(pixels.second, pixels.first);
+  if (task.m_onLoaded)
+    task.m_onLoaded(task.m_texture);
+}
+
+void AsyncTextureLoader::Update() {
+  std::vector<Task> finished;
+  for (auto it = m_tasks.begin(); it != m_tasks.end();) {
+    if (it->m_pixels.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready) {
+      ++it;
+      continue;
+    }
+    finished.emplace_back(std::move(*it));
+    it = m_tasks.erase(it);
+  }
+  //Callbacks may queue more textures.
+  for (auto &task : finished)
+    Finish(task);
+}
+
+void AsyncTextureLoader::Wait() {
+  auto tasks = std::move(m_tasks);
+  m_tasks.clear();
+  for (auto &task : tasks)
+    Finish(task);
+}
+
+bool AsyncTextureLoader::Empty() const { return m_tasks.empty(); }
+
+AsyncTextureLoader::~AsyncTextureLoader() {
+  //Nothing is uploaded, the decoding threads only have to be joined.
+  for (auto &task : m_tasks)
+    task.m_pixels.wait();
+}
@@ -0,0 +1,154 @@
+#include "BinarySidecar.hpp"
+
+using namespace EcoSysLab;
+
+thread_local BinarySidecar *CurrentSidecar = nullptr;
+
+BinarySidecar *BinarySidecar::GetCurrent() { return CurrentSidecar; }
+
+void BinarySidecar::SetCurrent(BinarySidecar *sidecar) {
+  CurrentSidecar = sidecar;
+}
+
+std::filesystem::path
+BinarySidecar::GetSidecarPath(const std::filesystem::path &path) {
+  auto sidecarPath = path;
+  sidecarPath += ".bin";
+  return sidecarPath;
+}
+
+bool BinarySidecar::OpenForWrite(const std::filesystem::path &path) {
+  Close();
+  m_path = path;
+  m_size = 0;
+  m_output.open(path, std::ofstream::out | std::ofstream::binary |
+                          std::ofstream::trunc);
+  return m_output.is_open();
+}
+
+bool BinarySidecar::OpenForRead(const std::filesystem::path &path) {
+  Close();
+  m_path = path;
+  m_input.open(path, std::ifstream::in | std::ifstream::binary |
+                         std::ifstream::ate);
+  if (!m_input.is_open())
+    return false;
+  m_inputSize = static_cast<size_t>(m_input.tellg());
+  return true;
+}
+
+bool BinarySidecar::IsWriting() const { return m_output.is_open(); }
+
+bool BinarySidecar::IsReading() const { return m_input.is_open(); }
+
+size_t BinarySidecar::Append(const void *data, size_t size) {
+  static const char padding[16] = {};
+  const size_t offset = (m_size + 15) / 16 * 16;
+  m_output.write(padding, offset - m_size);
+  m_output.write(static_cast<const char *>(data), size);
+  m_size = offset + size;
+  return offset;
+}
+
+bool BinarySidecar::Read(size_t offset, size_t size, void *target) const {
+  if (!m_input.is_open() || offset > m_inputSize ||
+      size > m_inputSize - offset)
+    return false;
+  m_input.clear();
+  m_input.seekg(static_cast<std::streamoff>(offset));
+  m_input.read(static_cast<char *>(target), static_cast<std::streamsize>(size));
+  return m_input.good();
+}
+
+bool BinarySidecar::Close() {
+  bool succeed = true;
+  if (m_output.is_open()) {
+    m_output.flush();
+    succeed = m_output.good();
+    m_output.close();
+  }
+  if (m_input.is_open())
+    m_input.close();
+  m_inputSize = 0;
+  return succeed;
+}
+
+void BinarySidecar::Save(const std::string &name, const void *data,
+                         size_t size, YAML::Emitter &out) {
+  auto *sidecar = GetCurrent();
+  if (sidecar && sidecar->IsWriting()) {
+    const size_t offset = sidecar->Append(data, size);
+    out << YAML::Key << name << YAML::Value << YAML::BeginMap;
+    out << YAML::Key << "Offset" << YAML::Value << (unsigned long long)offset;
+    out << YAML::Key << "Length" << YAML::Value << (unsigned long long)size;
+    out << YAML::EndMap;
+    return;
+  }
+  out << YAML::Key << name << YAML::Value
+      << YAML::Binary(static_cast<const unsigned char *>(data), size);
+}
+
+bool BinarySidecar::IsInSidecar(const YAML::Node &node) {
+  return node.IsMap() && node["Offset"] && node["Length"];
+}
+
+size_t BinarySidecar::GetSize(const YAML::Node &node) {
+  return node["Length"].as<unsigned long long>();
+}
+
+bool BinarySidecar::Load(const YAML::Node &node, void *target, size_t size) {
+  auto *sidecar = GetCurrent();
+  if (!sidecar || !sidecar->IsReading()) {
+    UNIENGINE_ERROR("Binary sidecar missing, load the file with its sidecar!");
+    return false;
+  }
+  if (!sidecar->Read(node["Offset"].as<unsigned long long>(), size, target)) {
+    UNIENGINE_ERROR("Binary sidecar out of range!");
+    return false;
+  }
+  return true;
+}
+
+bool BinarySidecar::Export(const std::shared_ptr<IAsset> &asset,
+                           const std::filesystem::path &path) {
+  BinarySidecar sidecar;
+  if (!sidecar.OpenForWrite(GetSidecarPath(path))) {
+    UNIENGINE_ERROR("Can't open file!");
+    return false;
+  }
+  {
+    BinarySidecarScope scope(sidecar);
+    asset->Export(path);
+  }
+  return sidecar.Close();
+}
+
+bool BinarySidecar::Import(const std::shared_ptr<IAsset> &asset,
+                           const std::filesystem::path &path) {
+  BinarySidecar sidecar;
+  //Files saved without a sidecar still load, their arrays are in the YAML.
+  sidecar.OpenForRead(GetSidecarPath(path));
+  BinarySidecarScope scope(sidecar);
+  asset->Import(path);
+  return true;
+}
+
+void BinarySidecar::OnInspect(const std::shared_ptr<IAsset> &asset,
+                              const std::string &typeName,
+                              const std::string &extension) {
+  FileUtils::SaveFile(
+      "Export with binary sidecar", typeName, {extension},
+      [&](const std::filesystem::path &path) { Export(asset, path); }, false);
+  FileUtils::OpenFile(
+      "Import with binary sidecar", typeName, {extension},
+      [&](const std::filesystem::path &path) { Import(asset, path); }, false);
+}
+
+BinarySidecarScope::BinarySidecarScope(BinarySidecar &sidecar) {
+  m_previous = BinarySidecar::GetCurrent();
+  BinarySidecar::SetCurrent(&sidecar);
+}
+
+BinarySidecarScope::~BinarySidecarScope() {
+  BinarySidecar::SetCurrent(m_previous);
+}
@@ -0,0 +1,386 @@
+#include "CanopyRaster.hpp"
+#include "FieldGround.hpp"
+#include "LeafData.hpp"
+#include "SorghumData.hpp"
+#include "SorghumField.hpp"
+#include "SorghumLayer.hpp"
+
+using namespace EcoSysLab;
+
+inline float EdgeFunction(const glm::vec2 &a, const glm::vec2 &b,
+                          const glm::vec2 &p) {
+  return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+}
+
+glm::ivec2 CanopyRaster::GetCoverResolution() const {
+  return m_resolution * m_coverResolution;
+}
+
+void CanopyRaster::Begin() {
+  m_cellSize = glm::max(m_cellSize, 0.001f);
+  m_heightBinAmount = glm::max(m_heightBinAmount, 1);
+  m_angleBinAmount = glm::max(m_angleBinAmount, 1);
+  m_coverResolution = glm::max(m_coverResolution, 1);
+  m_resolution = glm::max(glm::ivec2(glm::ceil((m_max - m_min) / m_cellSize)),
+                          glm::ivec2(1));
+  const int cellAmount = m_resolution.x * m_resolution.y;
+  m_leafArea.assign(cellAmount * m_heightBinAmount, 0.0f);
+  m_angleHistogram.assign(cellAmount * m_angleBinAmount, 0.0f);
+  m_cover.assign(cellAmount, 0.0f);
+  const auto coverResolution = GetCoverResolution();
+  m_coverMask.assign(coverResolution.x * coverResolution.y, 0);
+  m_pendingTriangles.clear();
+  m_cellGroundHeights.assign(cellAmount, 0.0f);
+  const auto ground = m_ground.Get<FieldGround>();
+  if (ground && ground->HasHeightCache()) {
+    const auto inverseGroundTransform = glm::inverse(m_groundTransform);
+    std::vector<glm::vec2> centers(cellAmount);
+    for (int cellZ = 0; cellZ < m_resolution.y; cellZ++) {
+      for (int cellX = 0; cellX < m_resolution.x; cellX++) {
+        const auto center = m_min + (glm::vec2(cellX, cellZ) + 0.5f) * m_cellSize;
+        const auto local =
+            inverseGroundTransform * glm::vec4(center.x, 0.0f, center.y, 1.0f);
+        centers[cellZ * m_resolution.x + cellX] = glm::vec2(local.x, local.z);
+      }
+    }
+    ground->SampleHeights(centers, m_cellGroundHeights);
+    for (int i = 0; i < cellAmount; i++) {
+      m_cellGroundHeights[i] =
+          (m_groundTransform * glm::vec4(centers[i].x, m_cellGroundHeights[i],
+                                         centers[i].y, 1.0f))
+              .y;
+    }
+  } else {
+    m_cellGroundHeights.assign(cellAmount, m_groundTransform[3].y);
+  }
+}
+
+void CanopyRaster::AddLeafTriangles(const std::vector<Vertex> &vertices,
+                                    const std::vector<glm::uvec3> &triangles,
+                                    const glm::mat4 &transform) {
+  if (m_coverMask.empty())
+    Begin();
+  for (const auto &triangle : triangles) {
+    m_pendingTriangles.emplace_back(transform * glm::vec4(vertices[triangle.x].m_position, 1.0f));
+    m_pendingTriangles.emplace_back(transform * glm::vec4(vertices[triangle.y].m_position, 1.0f));
+    m_pendingTriangles.emplace_back(transform * glm::vec4(vertices[triangle.z].m_position, 1.0f));
+  }
+  if (m_pendingTriangles.size() / 3 >= (size_t)m_batchTriangleAmount)
+    Flush();
+}
+
+void CanopyRaster::Flush() {
+  const int triangleAmount = m_pendingTriangles.size() / 3;
+  if (triangleAmount == 0)
+    return;
+  std::vector<TriangleRecord> records(triangleAmount);
+  const float angleBinSize = 90.0f / m_angleBinAmount;
+  std::vector<std::shared_future<void>> results;
+  Jobs::ParallelFor(
+      triangleAmount,
+      [&](unsigned i) {
+        const auto &v0 = m_pendingTriangles[i * 3];
+        const auto &v1 = m_pendingTriangles[i * 3 + 1];
+        const auto &v2 = m_pendingTriangles[i * 3 + 2];
+        auto &record = records[i];
+        record.m_p0 = glm::vec2(v0.x, v0.z);
+        record.m_p1 = glm::vec2(v1.x, v1.z);
+        record.m_p2 = glm::vec2(v2.x, v2.z);
+        const auto cross = glm::cross(v1 - v0, v2 - v0);
+        const float length = glm::length(cross);
+        record.m_area = length * 0.5f;
+        if (length == 0.0f)
+          return;
+        const auto centroid = (v0 + v1 + v2) / 3.0f;
+        const auto cellCoordinate = glm::ivec2(
+            glm::floor((glm::vec2(centroid.x, centroid.z) - m_min) / m_cellSize));
+        if (cellCoordinate.x >= 0 && cellCoordinate.y >= 0 &&
+            cellCoordinate.x < m_resolution.x && cellCoordinate.y < m_resolution.y)
+          record.m_cell = cellCoordinate.y * m_resolution.x + cellCoordinate.x;
+        const float groundHeight =
+            record.m_cell != -1 ? m_cellGroundHeights[record.m_cell] : 0.0f;
+        record.m_heightBin = glm::clamp(
+            (int)glm::floor((centroid.y - groundHeight) / m_heightBinSize), 0,
+            m_heightBinAmount - 1);
+        const float inclination = glm::degrees(
+            glm::acos(glm::clamp(glm::abs(cross.y) / length, 0.0f, 1.0f)));
+        record.m_angleBin = glm::min((int)(inclination / angleBinSize), m_angleBinAmount - 1);
+      },
+      results);
+  for (const auto &i : results)
+    i.wait();
+  results.clear();
+
+  // Area reduction is cheap, the cover rasterization below is split into
+  // bands of cell rows so every job writes its own part of the mask.
+  const auto coverResolution = GetCoverResolution();
+  const float sampleSize = m_cellSize / m_coverResolution;
+  std::vector<std::vector<int>> bands(m_resolution.y);
+  for (int i = 0; i < triangleAmount; i++) {
+    const auto &record = records[i];
+    if (record.m_area == 0.0f)
+      continue;
+    if (record.m_cell != -1) {
+      m_leafArea[record.m_cell * m_heightBinAmount + record.m_heightBin] += record.m_area;
+      m_angleHistogram[record.m_cell * m_angleBinAmount + record.m_angleBin] += record.m_area;
+    }
+    const float minZ = glm::min(glm::min(record.m_p0.y, record.m_p1.y), record.m_p2.y);
+    const float maxZ = glm::max(glm::max(record.m_p0.y, record.m_p1.y), record.m_p2.y);
+    const int startBand = glm::max(0, (int)glm::floor((minZ - m_min.y) / m_cellSize));
+    const int endBand = glm::min(m_resolution.y - 1, (int)glm::floor((maxZ - m_min.y) / m_cellSize));
+    for (int band = startBand; band <= endBand; band++)
+      bands[band].push_back(i);
+  }
+  Jobs::ParallelFor(
+      m_resolution.y,
+      [&](unsigned band) {
+        const int bandStart = band * m_coverResolution;
+        const int bandEnd = bandStart + m_coverResolution - 1;
+        for (const auto triangleIndex : bands[band]) {
+          const auto &record = records[triangleIndex];
+          const auto min = glm::min(glm::min(record.m_p0, record.m_p1), record.m_p2);
+          const auto max = glm::max(glm::max(record.m_p0, record.m_p1), record.m_p2);
+          const int startX = glm::max(0, (int)glm::ceil((min.x - m_min.x) / sampleSize - 0.5f));
+          const int endX = glm::min(coverResolution.x - 1, (int)glm::floor((max.x - m_min.x) / sampleSize - 0.5f));
+          const int startZ = glm::max(bandStart, (int)glm::ceil((min.y - m_min.y) / sampleSize - 0.5f));
+          const int endZ = glm::min(bandEnd, (int)glm::floor((max.y - m_min.y) / sampleSize - 0.5f));
+          for (int z = startZ; z <= endZ; z++) {
+            for (int x = startX; x <= endX; x++) {
+              auto &sample = m_coverMask[z * coverResolution.x + x];
+              if (sample)
+                continue;
+              const auto p = m_min + (glm::vec2(x, z) + 0.5f) * sampleSize;
+              const float e0 = EdgeFunction(record.m_p0, record.m_p1, p);
+              const float e1 = EdgeFunction(record.m_p1, record.m_p2, p);
+              const float e2 = EdgeFunction(record.m_p2, record.m_p0, p);
+              if ((e0 >= 0 && e1 >= 0 && e2 >= 0) || (e0 <= 0 && e1 <= 0 && e2 <= 0))
+                sample = 1;
+            }
+          }
+        }
+      },
+      results);
+  for (const auto &i : results)
+    i.wait();
+  m_pendingTriangles.clear();
+}
+
+void CanopyRaster::End() {
+  Flush();
+  const auto coverResolution = GetCoverResolution();
+  const float sampleAmount = m_coverResolution * m_coverResolution;
+  for (int cellZ = 0; cellZ < m_resolution.y; cellZ++) {
+    for (int cellX = 0; cellX < m_resolution.x; cellX++) {
+      int covered = 0;
+      for (int z = cellZ * m_coverResolution; z < (cellZ + 1) * m_coverResolution; z++) {
+        for (int x = cellX * m_coverResolution; x < (cellX + 1) * m_coverResolution; x++) {
+          covered += m_coverMask[z * coverResolution.x + x];
+        }
+      }
+      m_cover[cellZ * m_resolution.x + cellX] = covered / sampleAmount;
+    }
+  }
+  m_coverMask.clear();
+  m_coverMask.shrink_to_fit();
+}
+
+float CanopyRaster::GetLeafAreaIndex(int cell) const {
+  float area = 0.0f;
+  for (int i = 0; i < m_heightBinAmount; i++)
+    area += m_leafArea[cell * m_heightBinAmount + i];
+  return area / (m_cellSize * m_cellSize);
+}
+
+void CanopyRaster::RasterizeScene(const std::shared_ptr<Scene> &scene) {
+  auto sorghumLayer = Application::GetLayer<SorghumLayer>();
+  if (!sorghumLayer)
+    return;
+  Begin();
+  std::vector<Entity> plants;
+  scene->GetEntityArray(sorghumLayer->m_sorghumQuery, plants);
+  for (const auto &plant : plants) {
+    //Impostors have no leaves, they are formed in full for the raster.
+    if (scene->HasPrivateComponent<SorghumData>(plant))
+      scene->GetOrSetPrivateComponent<SorghumData>(plant).lock()->EnsureGeometry(
+          true);
+    const auto transform = scene->GetDataComponent<GlobalTransform>(plant).m_value;
+    scene->ForEachChild(plant, [&](Entity child) {
+      if (!scene->HasDataComponent<LeafTag>(child))
+        return;
+      auto leafData = scene->GetOrSetPrivateComponent<LeafData>(child).lock();
+      AddLeafTriangles(leafData->m_vertices, leafData->m_triangles, transform);
+    });
+  }
+  End();
+}
+
+void CanopyRaster::RasterizeField(const std::shared_ptr<SorghumField> &field) {
+  auto sorghumLayer = Application::GetLayer<SorghumLayer>();
+  if (!sorghumLayer || !field)
+    return;
+  if (field->m_newSorghums.empty())
+    field->GenerateMatrices();
+  auto scene = sorghumLayer->GetScene();
+  //Descriptor modes are resolved once for the whole table.
+  std::vector<int> modes(field->m_descriptors.size());
+  for (int i = 0; i < field->m_descriptors.size(); i++) {
+    modes[i] = field->m_descriptors[i].Get<ProceduralSorghum>()
+                   ? (int)SorghumMode::ProceduralSorghum
+                   : (int)SorghumMode::SorghumStateGenerator;
+  }
+  Begin();
+  const int size = glm::min((int)field->m_newSorghums.size(), field->m_sizeLimit);
+  for (int i = 0; i < size; i++) {
+    const auto &newSorghum = field->m_newSorghums[i];
+    // Only one plant exists at a time, its leaves are buffered before it is removed.
+    Entity sorghumEntity = sorghumLayer->CreateSorghum();
+    auto sorghumData =
+        scene->GetOrSetPrivateComponent<SorghumData>(sorghumEntity).lock();
+    if (newSorghum.m_descriptorIndex >= 0 &&
+        newSorghum.m_descriptorIndex < modes.size()) {
+      sorghumData->m_mode = modes[newSorghum.m_descriptorIndex];
+      sorghumData->m_descriptor =
+          field->m_descriptors[newSorghum.m_descriptorIndex];
+    }
+    sorghumData->m_seed = newSorghum.m_seed;
+    sorghumData->SetTime(1.0f);
+    const auto transform =
+        newSorghum.m_transform * glm::scale(glm::vec3(field->m_sorghumSize));
+    scene->ForEachChild(sorghumEntity, [&](Entity child) {
+      if (!scene->HasDataComponent<LeafTag>(child))
+        return;
+      auto leafData = scene->GetOrSetPrivateComponent<LeafData>(child).lock();
+      AddLeafTriangles(leafData->m_vertices, leafData->m_triangles, transform);
+    });
+    scene->DeleteEntity(sorghumEntity);
+  }
+  End();
+}
+
+void CanopyRaster::ExportBinary(const std::filesystem::path &path) const {
+  std::ofstream of(path, std::ofstream::out | std::ofstream::binary |
+                             std::ofstream::trunc);
+  if (!of.is_open()) {
+    UNIENGINE_ERROR("Can't open file!");
+    return;
+  }
+  const char magic[4] = {'C', 'N', 'P', 'R'};
+  const int header[5] = {1, m_resolution.x, m_resolution.y, m_heightBinAmount,
+                         m_angleBinAmount};
+  const float layout[4] = {m_min.x, m_min.y, m_cellSize, m_heightBinSize};
+  of.write(magic, sizeof(magic));
+  of.write((const char *)header, sizeof(header));
+  of.write((const char *)layout, sizeof(layout));
+  of.write((const char *)m_leafArea.data(), m_leafArea.size() * sizeof(float));
+  of.write((const char *)m_angleHistogram.data(),
+           m_angleHistogram.size() * sizeof(float));
+  of.write((const char *)m_cover.data(), m_cover.size() * sizeof(float));
+  of.close();
+  UNIENGINE_LOG("Canopy raster saved as " + path.string());
+}
+
+void CanopyRaster::ExportCSV(const std::filesystem::path &path) const {
+  std::ofstream of(path, std::ofstream::out | std::ofstream::trunc);
+  if (!of.is_open()) {
+    UNIENGINE_ERROR("Can't open file!");
+    return;
+  }
+  std::string data = "x,z,lai,cover";
+  for (int i = 0; i < m_heightBinAmount; i++)
+    data += ",area_h" + std::to_string(i);
+  for (int i = 0; i < m_angleBinAmount; i++)
+    data += ",angle_" + std::to_string(i);
+  data += "\n";
+  for (int cellZ = 0; cellZ < m_resolution.y; cellZ++) {
+    for (int cellX = 0; cellX < m_resolution.x; cellX++) {
+      const int cell = cellZ * m_resolution.x + cellX;
+      data += std::to_string(m_min.x + (cellX + 0.5f) * m_cellSize) + "," +
+              std::to_string(m_min.y + (cellZ + 0.5f) * m_cellSize) + "," +
+              std::to_string(GetLeafAreaIndex(cell)) + "," +
+              std::to_string(m_cover[cell]);
+      for (int i = 0; i < m_heightBinAmount; i++)
+        data += "," + std::to_string(m_leafArea[cell * m_heightBinAmount + i]);
+      for (int i = 0; i < m_angleBinAmount; i++)
+        data += "," + std::to_string(m_angleHistogram[cell * m_angleBinAmount + i]);
+      data += "\n";
+    }
+  }
+  of.write(data.c_str(), data.size());
+  of.close();
+  UNIENGINE_LOG("Canopy raster saved as " + path.string());
+}
+
+void CanopyRaster::OnInspect() {
+  ImGui::DragFloat2("Min", &m_min.x, 0.1f);
+  ImGui::DragFloat2("Max", &m_max.x, 0.1f);
+  ImGui::DragFloat("Cell size", &m_cellSize, 0.01f, 0.001f, 100.0f);
+  ImGui::DragFloat("Height bin size", &m_heightBinSize, 0.01f, 0.001f, 10.0f);
+  ImGui::DragInt("Height bins", &m_heightBinAmount, 1, 1, 1000);
+  ImGui::DragInt("Angle bins", &m_angleBinAmount, 1, 1, 90);
+  ImGui::DragInt("Cover samples per cell", &m_coverResolution, 1, 1, 64);
+  ImGui::DragInt("Batch triangles", &m_batchTriangleAmount, 1024, 1024, 1 << 26);
+  Editor::DragAndDropButton<SorghumField>(m_field, "Field");
+  Editor::DragAndDropButton<FieldGround>(m_ground, "Ground");
+  ImGui::DragFloat3("Ground position", &m_groundTransform[3].x, 0.01f);
+  if (ImGui::Button("Rasterize scene")) {
+    RasterizeScene(Application::GetActiveScene());
+  }
+  auto field = m_field.Get<SorghumField>();
+  if (field && ImGui::Button("Rasterize field")) {
+    RasterizeField(field);
+  }
+  ImGui::Text("Resolution: %d x %d", m_resolution.x, m_resolution.y);
+  if (!m_cover.empty()) {
+    FileUtils::SaveFile("Export binary", "Canopy raster", {".bin"},
+                        [this](const std::filesystem::path &path) {
+                          ExportBinary(path);
+                        });
+    FileUtils::SaveFile("Export CSV", "CSV", {".csv"},
+                        [this](const std::filesystem::path &path) {
+                          ExportCSV(path);
+                        });
+  }
+}
+
+void CanopyRaster::Serialize(YAML::Emitter &out) {
+  out << YAML::Key << "m_min" << YAML::Value << m_min;
+  out << YAML::Key << "m_max" << YAML::Value << m_max;
+  out << YAML::Key << "m_cellSize" << YAML::Value << m_cellSize;
+  out << YAML::Key << "m_heightBinSize" << YAML::Value << m_heightBinSize;
+  out << YAML::Key << "m_heightBinAmount" << YAML::Value << m_heightBinAmount;
+  out << YAML::Key << "m_angleBinAmount" << YAML::Value << m_angleBinAmount;
+  out << YAML::Key << "m_coverResolution" << YAML::Value << m_coverResolution;
+  out << YAML::Key << "m_batchTriangleAmount" << YAML::Value
+      << m_batchTriangleAmount;
+  m_field.Save("m_field", out);
+  m_ground.Save("m_ground", out);
+  out << YAML::Key << "m_groundTransform" << YAML::Value << m_groundTransform;
+}
+
+void CanopyRaster::Deserialize(const YAML::Node &in) {
+  if (in["m_min"])
+    m_min = in["m_min"].as<glm::vec2>();
+  if (in["m_max"])
+    m_max = in["m_max"].as<glm::vec2>();
+  if (in["m_cellSize"])
+    m_cellSize = in["m_cellSize"].as<float>();
+  if (in["m_heightBinSize"])
+    m_heightBinSize = in["m_heightBinSize"].as<float>();
+  if (in["m_heightBinAmount"])
+    m_heightBinAmount = in["m_heightBinAmount"].as<int>();
+  if (in["m_angleBinAmount"])
+    m_angleBinAmount = in["m_angleBinAmount"].as<int>();
+  if (in["m_coverResolution"])
+    m_coverResolution = in["m_coverResolution"].as<int>();
+  if (in["m_batchTriangleAmount"])
+    m_batchTriangleAmount = in["m_batchTriangleAmount"].as<int>();
+  m_field.Load("m_field", in);
+  m_ground.Load("m_ground", in);
+  if (in["m_groundTransform"])
+    m_groundTransform = in["m_groundTransform"].as<glm::mat4>();
+}
+
+void CanopyRaster::CollectAssetRef(std::vector<AssetRef> &list) {
+  list.push_back(m_field);
+  list.push_back(m_ground);
+}
@@ -0,0 +1,188 @@
+#include "CsvReader.hpp"
+#include <charconv>
+
+using namespace EcoSysLab;
+
+inline std::string_view TrimCell(std::string_view cell) {
+  while (!cell.empty() && (cell.front() == ' ' || cell.front() == '\t'))
+    cell.remove_prefix(1);
+  while (!cell.empty() &&
+         (cell.back() == ' ' || cell.back() == '\t' || cell.back() == '\r'))
+    cell.remove_suffix(1);
+  if (cell.size() >= 2 && cell.front() == '"' && cell.back() == '"') {
+    cell.remove_prefix(1);
+    cell.remove_suffix(1);
+  }
+  return cell;
+}
+
+bool CsvReader::Open(const std::filesystem::path &path) {
+  m_header.clear();
+  m_bindings.clear();
+  m_bodyOffset = 0;
+  if (!m_file.Open(path))
+    return false;
+  const auto *data = reinterpret_cast<const char *>(m_file.GetData());
+  const size_t size = m_file.GetSize();
+  size_t start = 0;
+  if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+    start = 3;
+  const auto *lineEnd =
+      static_cast<const char *>(memchr(data + start, '\n', size - start));
+  const size_t headerEnd = lineEnd ? lineEnd - data : size;
+  std::string_view header(data + start, headerEnd - start);
+  while (true) {
+    const auto comma = header.find(',');
+    m_header.emplace_back(TrimCell(header.substr(0, comma)));
+    if (comma == std::string_view::npos)
+      break;
+    header.remove_prefix(comma + 1);
+  }
+  m_bodyOffset = lineEnd ? headerEnd + 1 : size;
+  return true;
+}
+
+const std::vector<std::string> &CsvReader::GetHeader() const {
+  return m_header;
+}
+
+int CsvReader::GetColumnIndex(const std::string &name) const {
+  for (int i = 0; i < m_header.size(); i++) {
+    if (m_header[i] == name)
+      return i;
+  }
+  return -1;
+}
+
+void CsvReader::Bind(const std::string &name, std::vector<float> &column) {
+  Binding binding;
+  binding.m_name = name;
+  binding.m_floats = &column;
+  m_bindings.push_back(binding);
+}
+
+void CsvReader::Bind(const std::string &name,
+                     std::vector<std::string> &column) {
+  Binding binding;
+  binding.m_name = name;
+  binding.m_strings = &column;
+  m_bindings.push_back(binding);
+}
+
+bool CsvReader::Read() {
+  if (!m_file.IsOpen())
+    return false;
+  int lastColumn = 0;
+  for (auto &binding : m_bindings) {
+    binding.m_column = GetColumnIndex(binding.m_name);
+    if (binding.m_column == -1) {
+      UNIENGINE_ERROR("Column " + binding.m_name + " not found!");
+      return false;
+    }
+    lastColumn = glm::max(lastColumn, binding.m_column);
+  }
+  //Bindings of each column, a column may be bound more than once.
+  std::vector<std::vector<int>> columnBindings(lastColumn + 1);
+  for (int i = 0; i < m_bindings.size(); i++)
+    columnBindings[m_bindings[i].m_column].push_back(i);
+
+  const auto *data = reinterpret_cast<const char *>(m_file.GetData());
+  const size_t size = m_file.GetSize();
+  const size_t bodySize = size - m_bodyOffset;
+  //Chunks of at least 1MB, each starting right after a line break.
+  const size_t chunkAmount = glm::clamp(
+      bodySize >> 20, (size_t)1,
+      (size_t)glm::max(std::thread::hardware_concurrency(), 1u));
+  std::vector<size_t> chunkStarts(chunkAmount + 1);
+  chunkStarts[0] = m_bodyOffset;
+  chunkStarts[chunkAmount] = size;
+  for (size_t i = 1; i < chunkAmount; i++) {
+    size_t position =
+        glm::max(m_bodyOffset + bodySize * i / chunkAmount, chunkStarts[i - 1]);
+    const auto *lineEnd =
+        static_cast<const char *>(memchr(data + position, '\n', size - position));
+    chunkStarts[i] = lineEnd ? lineEnd - data + 1 : size;
+  }
+
+  struct ChunkResult {
+    std::vector<std::vector<float>> m_floats;
+    std::vector<std::vector<std::string>> m_strings;
+    std::string m_error;
+  };
+  std::vector<ChunkResult> chunkResults(chunkAmount);
+  std::vector<std::shared_future<void>> results;
+  Jobs::ParallelFor(
+      chunkAmount,
+      [&](unsigned chunkIndex) {
+        auto &chunkResult = chunkResults[chunkIndex];
+        chunkResult.m_floats.resize(m_bindings.size());
+        chunkResult.m_strings.resize(m_bindings.size());
+        const char *current = data + chunkStarts[chunkIndex];
+        const char *chunkEnd = data + chunkStarts[chunkIndex + 1];
+        while (current < chunkEnd) {
+          const auto *lineEnd = static_cast<const char *>(
+              memchr(current, '\n', chunkEnd - current));
+          if (!lineEnd)
+            lineEnd = chunkEnd;
+          std::string_view line(current, lineEnd - current);
+          current = lineEnd + 1;
+          if (TrimCell(line).empty())
+            continue;
+          for (int column = 0; column <= lastColumn; column++) {
+            const auto comma = line.find(',');
+            const auto cell = TrimCell(line.substr(0, comma));
+            line = comma == std::string_view::npos ? std::string_view()
+                                                   : line.substr(comma + 1);
+            for (const auto bindingIndex : columnBindings[column]) {
+              if (m_bindings[bindingIndex].m_strings) {
+                chunkResult.m_strings[bindingIndex].emplace_back(cell);
+                continue;
+              }
+              float value = std::numeric_limits<float>::quiet_NaN();
+              if (!cell.empty()) {
+                const auto parsed =
+                    std::from_chars(cell.data(), cell.data() + cell.size(), value);
+                if (parsed.ec != std::errc() ||
+                    parsed.ptr != cell.data() + cell.size()) {
+                  chunkResult.m_error = "Invalid value \"" + std::string(cell) +
+                                        "\" in column " +
+                                        m_bindings[bindingIndex].m_name + "!";
+                  return;
+                }
+              }
+              chunkResult.m_floats[bindingIndex].push_back(value);
+            }
+          }
+        }
+      },
+      results);
+  for (auto &i : results)
+    i.wait();
+
+  for (const auto &chunkResult : chunkResults) {
+    if (!chunkResult.m_error.empty()) {
+      UNIENGINE_ERROR(chunkResult.m_error);
+      return false;
+    }
+  }
+  for (int i = 0; i < m_bindings.size(); i++) {
+    auto &binding = m_bindings[i];
+    if (binding.m_strings) {
+      binding.m_strings->clear();
+      for (auto &chunkResult : chunkResults) {
+        auto &strings = chunkResult.m_strings[i];
+        binding.m_strings->insert(binding.m_strings->end(),
+                                  std::make_move_iterator(strings.begin()),
+                                  std::make_move_iterator(strings.end()));
+      }
+    } else {
+      binding.m_floats->clear();
+      for (const auto &chunkResult : chunkResults) {
+        const auto &floats = chunkResult.m_floats[i];
+        binding.m_floats->insert(binding.m_floats->end(), floats.begin(),
+                                 floats.end());
+      }
+    }
+  }
+  return true;
+}
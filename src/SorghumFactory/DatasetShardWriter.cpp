@@ -0,0 +1,95 @@
+#include "DatasetShardWriter.hpp"
+
+using namespace EcoSysLab;
+
+//Quotes a CSV field when it contains a separator, a quote or a line break.
+static std::string EscapeCsv(const std::string &field) {
+  if (field.find_first_of(",\"\r\n") == std::string::npos)
+    return field;
+  std::string escaped = "\"";
+  for (const auto c : field) {
+    if (c == '"')
+      escaped += '"';
+    escaped += c;
+  }
+  escaped += '"';
+  return escaped;
+}
+
+std::string DatasetShardWriter::GetShardName(int shardIndex) {
+  char name[32];
+  snprintf(name, sizeof(name), "shard_%05d.pack", shardIndex);
+  return name;
+}
+
+bool DatasetShardWriter::Open(const std::filesystem::path &folder,
+                              size_t maxShardSize) {
+  Close();
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_folder = folder;
+  m_maxShardSize = glm::max(maxShardSize, (size_t)1);
+  m_shardAmount = 0;
+  m_shardSize = 0;
+  m_entryAmount = 0;
+  std::error_code errorCode;
+  std::filesystem::create_directories(m_folder, errorCode);
+  m_index.open(m_folder / "index.csv", std::ofstream::out | std::ofstream::trunc);
+  if (!m_index.is_open()) {
+    UNIENGINE_ERROR("Can't open file!");
+    return false;
+  }
+  m_index << "name,shard,offset,length,type\n";
+  return OpenShard();
+}
+
+bool DatasetShardWriter::OpenShard() {
+  if (m_shard.is_open())
+    m_shard.close();
+  m_shard.open(m_folder / GetShardName(m_shardAmount),
+               std::ofstream::out | std::ofstream::binary |
+                   std::ofstream::trunc);
+  if (!m_shard.is_open()) {
+    UNIENGINE_ERROR("Can't open file!");
+    return false;
+  }
+  m_shardAmount++;
+  m_shardSize = 0;
+  return true;
+}
+
+bool DatasetShardWriter::IsOpen() const { return m_index.is_open(); }
+
+bool DatasetShardWriter::Append(const std::string &name,
+                                const std::string &type, const void *data,
+                                size_t size) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_index.is_open())
+    return false;
+  // An entry larger than the shard size still gets a shard of its own.
+  if (m_shardSize > 0 && m_shardSize + size > m_maxShardSize && !OpenShard())
+    return false;
+  m_shard.write(static_cast<const char *>(data), size);
+  if (!m_shard.good())
+    return false;
+  m_index << EscapeCsv(name) << ',' << m_shardAmount - 1 << ','
+          << m_shardSize << ',' << size << ',' << EscapeCsv(type) << '\n';
+  m_shardSize += size;
+  m_entryAmount++;
+  return true;
+}
+
+void DatasetShardWriter::Close() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_shard.is_open())
+    m_shard.close();
+  if (m_index.is_open())
+    m_index.close();
+}
+
+int DatasetShardWriter::GetShardAmount() const { return m_shardAmount; }
+
+size_t DatasetShardWriter::GetEntryAmount() const { return m_entryAmount; }
+
+size_t DatasetShardWriter::GetMaxShardSize() const { return m_maxShardSize; }
+
+DatasetShardWriter::~DatasetShardWriter() { Close(); }
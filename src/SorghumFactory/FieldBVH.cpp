@@ -0,0 +1,427 @@
+#include "FieldBVH.hpp"
+
+using namespace EcoSysLab;
+
+constexpr int SAHBinAmount = 12;
+
+inline float SurfaceArea(const glm::vec3 &min, const glm::vec3 &max) {
+  const auto extent = glm::max(max - min, glm::vec3(0.0f));
+  return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+inline bool RayBoxIntersect(const glm::vec3 &origin,
+                            const glm::vec3 &inverseDirection,
+                            const FieldBVHNode &node, float maxDistance,
+                            float &entry) {
+  const auto t0 = (node.m_min - origin) * inverseDirection;
+  const auto t1 = (node.m_max - origin) * inverseDirection;
+  const auto tMin = glm::min(t0, t1);
+  const auto tMax = glm::max(t0, t1);
+  entry = glm::max(glm::max(tMin.x, tMin.y), glm::max(tMin.z, 0.0f));
+  const float exit = glm::min(glm::min(tMax.x, tMax.y), glm::min(tMax.z, maxDistance));
+  return entry <= exit;
+}
+
+void FieldBVH::CollectTriangles(const std::shared_ptr<Scene> &scene,
+                                std::vector<FieldBVHTriangle> &triangles) const {
+  std::vector<std::shared_future<void>> results;
+  Jobs::ParallelFor(
+      m_geometries.size(),
+      [&](unsigned i) {
+        const auto &geometry = m_geometries[i];
+        const auto transform =
+            scene->GetDataComponent<GlobalTransform>(geometry.m_entity).m_value;
+        const auto &vertices = geometry.m_mesh->UnsafeGetVertices();
+        const auto &meshTriangles = geometry.m_mesh->UnsafeGetTriangles();
+        for (int j = 0; j < geometry.m_triangleCount; j++) {
+          const auto &triangle = meshTriangles[j];
+          auto &target = triangles[geometry.m_triangleStart + j];
+          target.m_v0 = transform * glm::vec4(vertices[triangle.x].m_position, 1.0f);
+          target.m_v1 = transform * glm::vec4(vertices[triangle.y].m_position, 1.0f);
+          target.m_v2 = transform * glm::vec4(vertices[triangle.z].m_position, 1.0f);
+        }
+      },
+      results);
+  for (const auto &i : results)
+    i.wait();
+}
+
+void FieldBVH::CollectGeometries(const std::shared_ptr<Scene> &scene,
+                                 const std::vector<Entity> &roots,
+                                 std::vector<GeometryRecord> &geometries) {
+  int triangleAmount = 0;
+  Entity currentRoot;
+  int ordinal = 0;
+  std::function<void(const Entity &)> collect = [&](const Entity &entity) {
+    if (scene->HasPrivateComponent<MeshRenderer>(entity)) {
+      auto mesh = scene->GetOrSetPrivateComponent<MeshRenderer>(entity)
+                      .lock()
+                      ->m_mesh.Get<Mesh>();
+      if (mesh && mesh->GetTriangleAmount() > 0) {
+        GeometryRecord record;
+        record.m_root = currentRoot;
+        record.m_ordinal = ordinal++;
+        record.m_entity = entity;
+        record.m_mesh = mesh;
+        record.m_vertexCount = mesh->GetVerticesAmount();
+        record.m_triangleStart = triangleAmount;
+        record.m_triangleCount = mesh->GetTriangleAmount();
+        triangleAmount += record.m_triangleCount;
+        geometries.push_back(record);
+      }
+    }
+    scene->ForEachChild(entity, collect);
+  };
+  for (const auto &root : roots) {
+    if (!scene->IsEntityValid(root))
+      continue;
+    currentRoot = root;
+    ordinal = 0;
+    collect(root);
+  }
+}
+
+void FieldBVH::Build(const std::shared_ptr<Scene> &scene,
+                     const std::vector<Entity> &roots) {
+  Clear();
+  CollectGeometries(scene, roots, m_geometries);
+  const int triangleAmount =
+      m_geometries.empty() ? 0
+                           : m_geometries.back().m_triangleStart +
+                                 m_geometries.back().m_triangleCount;
+  if (triangleAmount == 0)
+    return;
+
+  std::vector<FieldBVHTriangle> triangles(triangleAmount);
+  CollectTriangles(scene, triangles);
+  std::vector<glm::vec3> centroids(triangleAmount);
+  for (int i = 0; i < triangleAmount; i++) {
+    const auto &triangle = triangles[i];
+    centroids[i] = (triangle.m_v0 + triangle.m_v1 + triangle.m_v2) / 3.0f;
+  }
+  m_triangles = std::move(triangles);
+  m_triangleOrder.resize(triangleAmount);
+  std::iota(m_triangleOrder.begin(), m_triangleOrder.end(), 0);
+  m_nodes.reserve(2 * triangleAmount / glm::max(1, m_maxLeafSize) + 1);
+  BuildNode(0, triangleAmount, centroids);
+
+  // Lay triangles out in leaf order so each leaf reads a contiguous range.
+  std::vector<FieldBVHTriangle> sorted(triangleAmount);
+  std::vector<int> originalGeometry(triangleAmount);
+  for (int i = 0; i < m_geometries.size(); i++) {
+    const auto &geometry = m_geometries[i];
+    std::fill_n(originalGeometry.begin() + geometry.m_triangleStart,
+                geometry.m_triangleCount, i);
+  }
+  m_triangleGeometry.resize(triangleAmount);
+  for (int i = 0; i < triangleAmount; i++) {
+    sorted[i] = m_triangles[m_triangleOrder[i]];
+    m_triangleGeometry[i] = originalGeometry[m_triangleOrder[i]];
+  }
+  m_triangles = std::move(sorted);
+  UpdateBounds();
+}
+
+int FieldBVH::BuildNode(int start, int end, std::vector<glm::vec3> &centroids) {
+  const int nodeIndex = m_nodes.size();
+  m_nodes.emplace_back();
+  const int count = end - start;
+  glm::vec3 boundMin = glm::vec3(FLT_MAX), boundMax = glm::vec3(-FLT_MAX);
+  glm::vec3 centroidMin = glm::vec3(FLT_MAX), centroidMax = glm::vec3(-FLT_MAX);
+  for (int i = start; i < end; i++) {
+    const auto &triangle = m_triangles[m_triangleOrder[i]];
+    boundMin = glm::min(glm::min(boundMin, triangle.m_v0), glm::min(triangle.m_v1, triangle.m_v2));
+    boundMax = glm::max(glm::max(boundMax, triangle.m_v0), glm::max(triangle.m_v1, triangle.m_v2));
+    centroidMin = glm::min(centroidMin, centroids[m_triangleOrder[i]]);
+    centroidMax = glm::max(centroidMax, centroids[m_triangleOrder[i]]);
+  }
+  auto makeLeaf = [&]() {
+    m_nodes[nodeIndex].m_offset = start;
+    m_nodes[nodeIndex].m_count = count;
+    return nodeIndex;
+  };
+  if (count <= m_maxLeafSize)
+    return makeLeaf();
+
+  const auto extent = centroidMax - centroidMin;
+  int axis = 0;
+  if (extent.y > extent[axis])
+    axis = 1;
+  if (extent.z > extent[axis])
+    axis = 2;
+  int mid = start;
+  if (extent[axis] > 0.0f) {
+    // Binned SAH along the widest centroid axis.
+    int binCounts[SAHBinAmount] = {};
+    glm::vec3 binMin[SAHBinAmount], binMax[SAHBinAmount];
+    std::fill_n(binMin, SAHBinAmount, glm::vec3(FLT_MAX));
+    std::fill_n(binMax, SAHBinAmount, glm::vec3(-FLT_MAX));
+    const float binScale = SAHBinAmount / extent[axis];
+    auto binOf = [&](int triangleIndex) {
+      return glm::min(SAHBinAmount - 1,
+                      (int)((centroids[triangleIndex][axis] - centroidMin[axis]) * binScale));
+    };
+    for (int i = start; i < end; i++) {
+      const auto &triangle = m_triangles[m_triangleOrder[i]];
+      const int bin = binOf(m_triangleOrder[i]);
+      binCounts[bin]++;
+      binMin[bin] = glm::min(glm::min(binMin[bin], triangle.m_v0), glm::min(triangle.m_v1, triangle.m_v2));
+      binMax[bin] = glm::max(glm::max(binMax[bin], triangle.m_v0), glm::max(triangle.m_v1, triangle.m_v2));
+    }
+    float rightCost[SAHBinAmount];
+    glm::vec3 accumulatedMin = glm::vec3(FLT_MAX), accumulatedMax = glm::vec3(-FLT_MAX);
+    int accumulatedCount = 0;
+    for (int i = SAHBinAmount - 1; i > 0; i--) {
+      accumulatedMin = glm::min(accumulatedMin, binMin[i]);
+      accumulatedMax = glm::max(accumulatedMax, binMax[i]);
+      accumulatedCount += binCounts[i];
+      rightCost[i] = accumulatedCount * SurfaceArea(accumulatedMin, accumulatedMax);
+    }
+    float bestCost = FLT_MAX;
+    int bestSplit = -1;
+    accumulatedMin = glm::vec3(FLT_MAX);
+    accumulatedMax = glm::vec3(-FLT_MAX);
+    accumulatedCount = 0;
+    for (int i = 0; i < SAHBinAmount - 1; i++) {
+      accumulatedMin = glm::min(accumulatedMin, binMin[i]);
+      accumulatedMax = glm::max(accumulatedMax, binMax[i]);
+      accumulatedCount += binCounts[i];
+      const float cost = accumulatedCount * SurfaceArea(accumulatedMin, accumulatedMax) + rightCost[i + 1];
+      if (accumulatedCount > 0 && accumulatedCount < count && cost < bestCost) {
+        bestCost = cost;
+        bestSplit = i;
+      }
+    }
+    if (bestSplit != -1 &&
+        bestCost >= count * SurfaceArea(boundMin, boundMax) && count <= 4 * m_maxLeafSize)
+      return makeLeaf();
+    if (bestSplit != -1) {
+      mid = std::partition(m_triangleOrder.begin() + start,
+                           m_triangleOrder.begin() + end,
+                           [&](int triangleIndex) { return binOf(triangleIndex) <= bestSplit; }) -
+            m_triangleOrder.begin();
+    }
+  }
+  if (mid == start || mid == end) {
+    mid = (start + end) / 2;
+    std::nth_element(m_triangleOrder.begin() + start,
+                     m_triangleOrder.begin() + mid,
+                     m_triangleOrder.begin() + end, [&](int a, int b) {
+                       return centroids[a][axis] < centroids[b][axis];
+                     });
+  }
+  BuildNode(start, mid, centroids);
+  const int right = BuildNode(mid, end, centroids);
+  m_nodes[nodeIndex].m_offset = right;
+  return nodeIndex;
+}
+
+void FieldBVH::UpdateBounds() {
+  // Children are always stored after their parent.
+  for (int i = (int)m_nodes.size() - 1; i >= 0; i--) {
+    auto &node = m_nodes[i];
+    node.m_min = glm::vec3(FLT_MAX);
+    node.m_max = glm::vec3(-FLT_MAX);
+    if (node.m_count > 0) {
+      for (int j = node.m_offset; j < node.m_offset + node.m_count; j++) {
+        const auto &triangle = m_triangles[j];
+        node.m_min = glm::min(glm::min(node.m_min, triangle.m_v0), glm::min(triangle.m_v1, triangle.m_v2));
+        node.m_max = glm::max(glm::max(node.m_max, triangle.m_v0), glm::max(triangle.m_v1, triangle.m_v2));
+      }
+    } else {
+      const auto &left = m_nodes[i + 1];
+      const auto &right = m_nodes[node.m_offset];
+      node.m_min = glm::min(left.m_min, right.m_min);
+      node.m_max = glm::max(left.m_max, right.m_max);
+    }
+  }
+}
+
+bool FieldBVH::Refit(const std::shared_ptr<Scene> &scene,
+                     const std::vector<Entity> &roots) {
+  std::vector<GeometryRecord> geometries;
+  CollectGeometries(scene, roots, geometries);
+  if (geometries.size() != m_geometries.size())
+    return false;
+  for (int i = 0; i < geometries.size(); i++) {
+    const auto &current = geometries[i];
+    const auto &geometry = m_geometries[i];
+    if (current.m_root != geometry.m_root ||
+        current.m_ordinal != geometry.m_ordinal ||
+        current.m_vertexCount != geometry.m_vertexCount ||
+        current.m_triangleCount != geometry.m_triangleCount)
+      return false;
+  }
+  //Hits and queries report the current entities.
+  m_geometries = std::move(geometries);
+  std::vector<FieldBVHTriangle> triangles(m_triangles.size());
+  CollectTriangles(scene, triangles);
+  for (int i = 0; i < m_triangles.size(); i++) {
+    m_triangles[i] = triangles[m_triangleOrder[i]];
+  }
+  UpdateBounds();
+  return true;
+}
+
+void FieldBVH::Clear() {
+  m_geometries.clear();
+  m_nodes.clear();
+  m_triangles.clear();
+  m_triangleOrder.clear();
+  m_triangleGeometry.clear();
+}
+
+bool FieldBVH::Empty() const { return m_nodes.empty(); }
+
+size_t FieldBVH::GetNodeAmount() const { return m_nodes.size(); }
+
+size_t FieldBVH::GetTriangleAmount() const { return m_triangles.size(); }
+
+void FieldBVH::GetBound(glm::vec3 &min, glm::vec3 &max) const {
+  if (m_nodes.empty()) {
+    min = max = glm::vec3(0.0f);
+    return;
+  }
+  min = m_nodes[0].m_min;
+  max = m_nodes[0].m_max;
+}
+
+bool FieldBVH::RayCast(const glm::vec3 &origin, const glm::vec3 &direction,
+                       FieldBVHRayHit &hit, float maxDistance) const {
+  if (m_nodes.empty())
+    return false;
+  const auto inverseDirection = 1.0f / direction;
+  int closestTriangle = -1;
+  float closestDistance = maxDistance;
+  std::vector<int> stack;
+  stack.reserve(64);
+  stack.push_back(0);
+  while (!stack.empty()) {
+    const int nodeIndex = stack.back();
+    stack.pop_back();
+    const auto &node = m_nodes[nodeIndex];
+    float entry;
+    if (!RayBoxIntersect(origin, inverseDirection, node, closestDistance, entry))
+      continue;
+    if (node.m_count > 0) {
+      for (int i = node.m_offset; i < node.m_offset + node.m_count; i++) {
+        // Moller-Trumbore.
+        const auto &triangle = m_triangles[i];
+        const auto e1 = triangle.m_v1 - triangle.m_v0;
+        const auto e2 = triangle.m_v2 - triangle.m_v0;
+        const auto p = glm::cross(direction, e2);
+        const float determinant = glm::dot(e1, p);
+        if (glm::abs(determinant) < 1e-12f)
+          continue;
+        const float inverseDeterminant = 1.0f / determinant;
+        const auto s = origin - triangle.m_v0;
+        const float u = glm::dot(s, p) * inverseDeterminant;
+        if (u < 0.0f || u > 1.0f)
+          continue;
+        const auto q = glm::cross(s, e1);
+        const float v = glm::dot(direction, q) * inverseDeterminant;
+        if (v < 0.0f || u + v > 1.0f)
+          continue;
+        const float t = glm::dot(e2, q) * inverseDeterminant;
+        if (t > 0.0f && t < closestDistance) {
+          closestDistance = t;
+          closestTriangle = i;
+        }
+      }
+      continue;
+    }
+    // Visit the nearer child first.
+    const int left = nodeIndex + 1;
+    const int right = node.m_offset;
+    float leftEntry, rightEntry;
+    const bool hitLeft = RayBoxIntersect(origin, inverseDirection, m_nodes[left], closestDistance, leftEntry);
+    const bool hitRight = RayBoxIntersect(origin, inverseDirection, m_nodes[right], closestDistance, rightEntry);
+    if (hitLeft && hitRight) {
+      if (leftEntry < rightEntry) {
+        stack.push_back(right);
+        stack.push_back(left);
+      } else {
+        stack.push_back(left);
+        stack.push_back(right);
+      }
+    } else if (hitLeft) {
+      stack.push_back(left);
+    } else if (hitRight) {
+      stack.push_back(right);
+    }
+  }
+  if (closestTriangle == -1)
+    return false;
+  const auto &triangle = m_triangles[closestTriangle];
+  hit.m_distance = closestDistance;
+  hit.m_position = origin + direction * closestDistance;
+  hit.m_normal = glm::normalize(glm::cross(triangle.m_v1 - triangle.m_v0, triangle.m_v2 - triangle.m_v0));
+  const auto &geometry = m_geometries[m_triangleGeometry[closestTriangle]];
+  hit.m_entity = geometry.m_entity;
+  hit.m_triangleIndex = m_triangleOrder[closestTriangle] - geometry.m_triangleStart;
+  return true;
+}
+
+template <typename Overlap>
+void FieldBVH::Query(const Overlap &overlap, std::vector<Entity> &entities) const {
+  if (m_nodes.empty())
+    return;
+  std::vector<bool> marked(m_geometries.size(), false);
+  std::vector<int> stack;
+  stack.push_back(0);
+  while (!stack.empty()) {
+    const int nodeIndex = stack.back();
+    stack.pop_back();
+    const auto &node = m_nodes[nodeIndex];
+    if (!overlap(node.m_min, node.m_max))
+      continue;
+    if (node.m_count > 0) {
+      for (int i = node.m_offset; i < node.m_offset + node.m_count; i++) {
+        const auto &triangle = m_triangles[i];
+        if (marked[m_triangleGeometry[i]] ||
+            !overlap(glm::min(glm::min(triangle.m_v0, triangle.m_v1), triangle.m_v2),
+                     glm::max(glm::max(triangle.m_v0, triangle.m_v1), triangle.m_v2)))
+          continue;
+        marked[m_triangleGeometry[i]] = true;
+        entities.push_back(m_geometries[m_triangleGeometry[i]].m_entity);
+      }
+      continue;
+    }
+    stack.push_back(node.m_offset);
+    stack.push_back(nodeIndex + 1);
+  }
+}
+
+void FieldBVH::QueryAABB(const glm::vec3 &min, const glm::vec3 &max,
+                         std::vector<Entity> &entities) const {
+  Query(
+      [&](const glm::vec3 &boxMin, const glm::vec3 &boxMax) {
+        return glm::all(glm::lessThanEqual(boxMin, max)) &&
+               glm::all(glm::greaterThanEqual(boxMax, min));
+      },
+      entities);
+}
+
+void FieldBVH::FrustumCull(const glm::mat4 &viewProjection,
+                           std::vector<Entity> &entities) const {
+  glm::vec4 planes[6];
+  const auto row = [&](int i) {
+    return glm::vec4(viewProjection[0][i], viewProjection[1][i],
+                     viewProjection[2][i], viewProjection[3][i]);
+  };
+  for (int i = 0; i < 3; i++) {
+    planes[i * 2] = row(3) + row(i);
+    planes[i * 2 + 1] = row(3) - row(i);
+  }
+  Query(
+      [&](const glm::vec3 &boxMin, const glm::vec3 &boxMax) {
+        for (const auto &plane : planes) {
+          const glm::vec3 normal = plane;
+          const auto positive = glm::mix(boxMin, boxMax, glm::greaterThan(normal, glm::vec3(0.0f)));
+          if (glm::dot(normal, positive) + plane.w < 0.0f)
+            return false;
+        }
+        return true;
+      },
+      entities);
+}
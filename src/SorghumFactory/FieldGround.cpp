@@ -6,41 +6,168 @@
 #include "glm/gtc/noise.hpp"
 
 using namespace EcoSysLab;
+
+#pragma region Simplex noise
+//Lane-wise port of glm::simplex(vec3). Every step is branch free so the batch loop below
+//vectorizes and evaluates several vertices per instruction.
+static float FastFloor(const float x) {
+	const float t = static_cast<float>(static_cast<int>(x));
+	return t > x ? t - 1.0f : t;
+}
+static float Mod289(const float x) { return x - FastFloor(x * (1.0f / 289.0f)) * 289.0f; }
+static float Permute(const float x) { return Mod289((x * 34.0f + 1.0f) * x); }
+static float Step(const float edge, const float x) { return x < edge ? 0.0f : 1.0f; }
+
+static float SimplexNoiseLane(const float vx, const float vy, const float vz) {
+	constexpr float cx = 1.0f / 6.0f;
+	constexpr float cy = 1.0f / 3.0f;
+	constexpr float nsx = 2.0f / 7.0f;
+	constexpr float nsy = 0.5f / 7.0f - 1.0f;
+	constexpr float nsz = 1.0f / 7.0f;
+	// First corner
+	const float s = (vx + vy + vz) * cy;
+	float ix = FastFloor(vx + s);
+	float iy = FastFloor(vy + s);
+	float iz = FastFloor(vz + s);
+	const float t = (ix + iy + iz) * cx;
+	const float x0[3] = { vx - ix + t, vy - iy + t, vz - iz + t };
+	// Other corners
+	const float gx = Step(x0[1], x0[0]);
+	const float gy = Step(x0[2], x0[1]);
+	const float gz = Step(x0[0], x0[2]);
+	const float i1[3] = { glm::min(gx, 1.0f - gz), glm::min(gy, 1.0f - gx), glm::min(gz, 1.0f - gy) };
+	const float i2[3] = { glm::max(gx, 1.0f - gz), glm::max(gy, 1.0f - gx), glm::max(gz, 1.0f - gy) };
+	const float corners[4][3] = {
+		{ x0[0], x0[1], x0[2] },
+		{ x0[0] - i1[0] + cx, x0[1] - i1[1] + cx, x0[2] - i1[2] + cx },
+		{ x0[0] - i2[0] + cy, x0[1] - i2[1] + cy, x0[2] - i2[2] + cy },
+		{ x0[0] - 0.5f, x0[1] - 0.5f, x0[2] - 0.5f } };
+	const float offsets[4][3] = {
+		{ 0.0f, 0.0f, 0.0f },
+		{ i1[0], i1[1], i1[2] },
+		{ i2[0], i2[1], i2[2] },
+		{ 1.0f, 1.0f, 1.0f } };
+	// Permutations
+	ix = Mod289(ix);
+	iy = Mod289(iy);
+	iz = Mod289(iz);
+	float result = 0.0f;
+	for (int k = 0; k < 4; k++) {
+		const float p = Permute(Permute(Permute(iz + offsets[k][2]) + iy + offsets[k][1]) + ix + offsets[k][0]);
+		// Gradients: 7x7 points over a square, mapped onto an octahedron.
+		const float j = p - 49.0f * FastFloor(p * nsz * nsz);
+		const float xi = FastFloor(j * nsz);
+		const float yi = FastFloor(j - 7.0f * xi);
+		const float x = xi * nsx + nsy;
+		const float y = yi * nsx + nsy;
+		const float h = 1.0f - glm::abs(x) - glm::abs(y);
+		const float sh = -Step(h, 0.0f);
+		const float gradient[3] = {
+			x + (FastFloor(x) * 2.0f + 1.0f) * sh,
+			y + (FastFloor(y) * 2.0f + 1.0f) * sh,
+			h };
+		const float norm = 1.79284291400159f - 0.85373472095314f *
+			(gradient[0] * gradient[0] + gradient[1] * gradient[1] + gradient[2] * gradient[2]);
+		const auto& c = corners[k];
+		float m = glm::max(0.6f - (c[0] * c[0] + c[1] * c[1] + c[2] * c[2]), 0.0f);
+		m = m * m;
+		result += m * m * norm * (gradient[0] * c[0] + gradient[1] * c[1] + gradient[2] * c[2]);
+	}
+	return 42.0f * result;
+}
+
+constexpr int NoiseLaneWidth = 8;
+static void SimplexNoiseBatch(const float* x, const float* y, const float* z, float* out, const int count) {
+	for (int i = 0; i < count; i++) {
+		out[i] = SimplexNoiseLane(x[i], y[i], z[i]);
+	}
+}
+#pragma endregion
+
+void FieldGround::GenerateHeights(const glm::ivec2& start, const glm::ivec2& end, const float depth,
+	const glm::vec3& randomPositionOffset, std::vector<float>& heights) const {
+	const int rowSize = end.y - start.y + 1;
+	const int rowAmount = end.x - start.x + 1;
+	heights.resize(rowAmount * rowSize);
+	std::vector<std::shared_future<void>> results;
+	Jobs::ParallelFor(
+		rowAmount,
+		[&](unsigned row) {
+			const int i = start.x + (int)row;
+			const float x = m_scale.x * i;
+			float px[NoiseLaneWidth], py[NoiseLaneWidth], pz[NoiseLaneWidth];
+			float z[NoiseLaneWidth], height[NoiseLaneWidth], noise[NoiseLaneWidth];
+			for (int blockStart = 0; blockStart < rowSize; blockStart += NoiseLaneWidth) {
+				const int lanes = glm::min(NoiseLaneWidth, rowSize - blockStart);
+				for (int l = 0; l < lanes; l++) {
+					z[l] = m_scale.y * (start.y + blockStart + l);
+					height[l] = glm::min(0.0f, depth * glm::cos(z[l] * m_rowWidth));
+				}
+				for (const auto& noiseDescriptor : m_noiseDescriptors)
+				{
+					for (int l = 0; l < lanes; l++) {
+						px[l] = noiseDescriptor.m_noiseScale * x + randomPositionOffset.x;
+						py[l] = noiseDescriptor.m_noiseScale * height[l] + randomPositionOffset.y;
+						pz[l] = noiseDescriptor.m_noiseScale * z[l] + randomPositionOffset.z;
+					}
+					SimplexNoiseBatch(px, py, pz, noise, lanes);
+					for (int l = 0; l < lanes; l++) {
+						height[l] += glm::clamp(noise[l] * noiseDescriptor.m_noiseIntensity,
+							noiseDescriptor.m_heightMin, noiseDescriptor.m_heightMax);
+					}
+				}
+				std::memcpy(&heights[row * rowSize + blockStart], height, lanes * sizeof(float));
+			}
+		},
+		results);
+	for (const auto& i : results)
+		i.wait();
+}
+
+void FieldGround::GenerateGeometry(const glm::ivec2& start, const glm::ivec2& end, const std::vector<float>& heights,
+	std::vector<Vertex>& vertices, std::vector<glm::uvec3>& triangles) const {
+	const int rowSize = end.y - start.y + 1;
+	const int rowAmount = end.x - start.x + 1;
+	vertices.resize(rowAmount * rowSize);
+	triangles.resize(2 * (rowAmount - 1) * (rowSize - 1));
+	std::vector<std::shared_future<void>> results;
+	Jobs::ParallelFor(
+		rowAmount,
+		[&](unsigned row) {
+			const int i = start.x + (int)row;
+			for (int column = 0; column < rowSize; column++) {
+				const int j = start.y + column;
+				auto& vertex = vertices[row * rowSize + column];
+				vertex = Vertex();
+				vertex.m_position = glm::vec3(m_scale.x * i, heights[row * rowSize + column], m_scale.y * j);
+				vertex.m_texCoord = glm::vec2((float)i / (2 * m_size.x + 1),
+					(float)j / (2 * m_size.y + 1));
+			}
+			if (row + 1 == rowAmount) return;
+			for (int column = 0; column < rowSize - 1; column++) {
+				const unsigned current = row * rowSize + column;
+				const unsigned next = (row + 1) * rowSize + column;
+				const auto triangleIndex = 2 * (row * (rowSize - 1) + column);
+				triangles[triangleIndex] = glm::uvec3(current, current + 1, next);
+				triangles[triangleIndex + 1] = glm::uvec3(next + 1, next, current + 1);
+			}
+		},
+		results);
+	for (const auto& i : results)
+		i.wait();
+}
+
 Entity FieldGround::GenerateMesh(float overrideDepth) {
 	std::vector<Vertex> vertices;
 	std::vector<glm::uvec3> triangles;
-	Vertex archetype;
 	glm::vec3 randomPositionOffset =
 		glm::linearRand(glm::vec3(0.0f), glm::vec3(10000.0f));
-	for (int i = -m_size.x; i <= m_size.x; i++) {
-		for (int j = -m_size.y; j <= m_size.y; j++) {
-			archetype.m_position.x = m_scale.x * i;
-			archetype.m_position.z = m_scale.y * j;
-			archetype.m_position.y =
-				glm::min(0.0f, (overrideDepth < 0.0f ? m_alleyDepth : overrideDepth) *
-					glm::cos(archetype.m_position.z * m_rowWidth));
-			for (const auto& noiseDescriptor : m_noiseDescriptors)
-			{
-				float noise = glm::simplex(noiseDescriptor.m_noiseScale * archetype.m_position +
-					randomPositionOffset) *
-					noiseDescriptor.m_noiseIntensity;
-				archetype.m_position.y += glm::clamp(noise, noiseDescriptor.m_heightMin, noiseDescriptor.m_heightMax);
-			}
-			archetype.m_texCoord = glm::vec2((float)i / (2 * m_size.x + 1),
-				(float)j / (2 * m_size.y + 1));
-			vertices.push_back(archetype);
-		}
-	}
+	const float depth = overrideDepth < 0.0f ? m_alleyDepth : overrideDepth;
+	GenerateHeights(-m_size, m_size, depth, randomPositionOffset, m_heights);
+	GenerateGeometry(-m_size, m_size, m_heights, vertices, triangles);
+	m_heightCacheStart = -m_size;
+	m_heightCacheSize = m_size * 2 + 1;
 
-	for (int i = 0; i < 2 * m_size.x; i++) {
-		for (int j = 0; j < 2 * m_size.y; j++) {
-			int n = 2 * m_size.x + 1;
-			triangles.emplace_back(i + j * n, i + 1 + j * n, i + (j + 1) * n);
-			triangles.emplace_back(i + 1 + (j + 1) * n, i + (j + 1) * n,
-				i + 1 + j * n);
-		}
-	}
-	
 	auto scene = Application::GetActiveScene();
 	auto owner = scene->CreateEntity("Ground");
 
@@ -54,6 +181,86 @@ Entity FieldGround::GenerateMesh(float overrideDepth) {
 
 	return owner;
 }
+
+Entity FieldGround::GenerateTiledMesh(float overrideDepth) {
+	if (m_tileSize <= 0) return GenerateMesh(overrideDepth);
+	std::vector<float> heights;
+	std::vector<Vertex> vertices;
+	std::vector<glm::uvec3> triangles;
+	glm::vec3 randomPositionOffset =
+		glm::linearRand(glm::vec3(0.0f), glm::vec3(10000.0f));
+	const float depth = overrideDepth < 0.0f ? m_alleyDepth : overrideDepth;
+
+	auto scene = Application::GetActiveScene();
+	auto owner = scene->CreateEntity("Ground");
+	auto material = ProjectManager::CreateTemporaryAsset<Material>();
+	m_heightCacheStart = -m_size;
+	m_heightCacheSize = m_size * 2 + 1;
+	m_heights.resize(m_heightCacheSize.x * m_heightCacheSize.y);
+	//Tiles share their border vertices so the surface stays watertight. Only one tile is
+	//resident at a time, each one is uploaded before the next is generated.
+	for (int tileX = -m_size.x; tileX < m_size.x; tileX += m_tileSize) {
+		for (int tileZ = -m_size.y; tileZ < m_size.y; tileZ += m_tileSize) {
+			const glm::ivec2 start = glm::ivec2(tileX, tileZ);
+			const glm::ivec2 end = glm::min(start + m_tileSize, m_size);
+			GenerateHeights(start, end, depth, randomPositionOffset, heights);
+			GenerateGeometry(start, end, heights, vertices, triangles);
+			const int rowSize = end.y - start.y + 1;
+			for (int row = 0; row <= end.x - start.x; row++) {
+				std::memcpy(&m_heights[(start.x - m_heightCacheStart.x + row) * m_heightCacheSize.y + start.y - m_heightCacheStart.y],
+					&heights[row * rowSize], rowSize * sizeof(float));
+			}
+			auto tile = scene->CreateEntity("Ground Tile");
+			scene->SetParent(tile, owner);
+			auto meshRenderer =
+				scene->GetOrSetPrivateComponent<MeshRenderer>(tile).lock();
+			auto mesh = ProjectManager::CreateTemporaryAsset<Mesh>();
+			mesh->SetVertices(17, vertices, triangles);
+			meshRenderer->m_mesh = mesh;
+			meshRenderer->m_material = material;
+		}
+	}
+	return owner;
+}
+
+bool FieldGround::HasHeightCache() const {
+	return !m_heights.empty();
+}
+float FieldGround::GetCachedHeight(const int row, const int column) const {
+	return m_heights[glm::clamp(row, 0, m_heightCacheSize.x - 1) * m_heightCacheSize.y +
+		glm::clamp(column, 0, m_heightCacheSize.y - 1)];
+}
+float FieldGround::SampleHeight(const float x, const float z) const {
+	if (m_heights.empty()) return 0.0f;
+	const float gridX = glm::clamp(x / m_scale.x - m_heightCacheStart.x, 0.0f, (float)(m_heightCacheSize.x - 1));
+	const float gridZ = glm::clamp(z / m_scale.y - m_heightCacheStart.y, 0.0f, (float)(m_heightCacheSize.y - 1));
+	const int row = (int)gridX;
+	const int column = (int)gridZ;
+	const float a = gridX - row;
+	const float b = gridZ - column;
+	return glm::mix(
+		glm::mix(GetCachedHeight(row, column), GetCachedHeight(row, column + 1), b),
+		glm::mix(GetCachedHeight(row + 1, column), GetCachedHeight(row + 1, column + 1), b), a);
+}
+glm::vec3 FieldGround::SampleNormal(const float x, const float z) const {
+	if (m_heights.empty()) return glm::vec3(0, 1, 0);
+	const float dx = (SampleHeight(x + m_scale.x, z) - SampleHeight(x - m_scale.x, z)) / (2.0f * m_scale.x);
+	const float dz = (SampleHeight(x, z + m_scale.y) - SampleHeight(x, z - m_scale.y)) / (2.0f * m_scale.y);
+	return glm::normalize(glm::vec3(-dx, 1.0f, -dz));
+}
+void FieldGround::SampleHeights(const std::vector<glm::vec2>& positions, std::vector<float>& heights) const {
+	heights.resize(positions.size());
+	std::vector<std::shared_future<void>> results;
+	Jobs::ParallelFor(
+		positions.size(),
+		[&](unsigned i) {
+			heights[i] = SampleHeight(positions[i].x, positions[i].y);
+		},
+		results);
+	for (const auto& i : results)
+		i.wait();
+}
+
 void FieldGround::OnInspect() {
 	static bool autoRefresh = false;
 	ImGui::Checkbox("Auto refresh", &autoRefresh);
@@ -61,6 +268,7 @@ void FieldGround::OnInspect() {
 	changed = changed || ImGui::DragInt2("Size", &m_size.x);
 	changed = changed || ImGui::DragFloat("Row Width", &m_rowWidth);
 	changed = changed || ImGui::DragFloat("Alley Depth", &m_alleyDepth);
+	if (ImGui::DragInt("Tile size", &m_tileSize, 1, 0, 1024)) m_tileSize = glm::max(0, m_tileSize);
 	if (ImGui::Button("New start descriptor")) {
 		changed = true;
 		m_noiseDescriptors.emplace_back();
@@ -91,7 +299,8 @@ void FieldGround::OnInspect() {
 	}
 
 	if (ImGui::Button("Apply") || (changed && autoRefresh)) {
-		GenerateMesh();
+		if (m_tileSize > 0) GenerateTiledMesh();
+		else GenerateMesh();
 	}
 }
 void FieldGround::Serialize(YAML::Emitter& out) {
@@ -99,6 +308,7 @@ void FieldGround::Serialize(YAML::Emitter& out) {
 	out << YAML::Key << "m_size" << YAML::Value << m_size;
 	out << YAML::Key << "m_rowWidth" << YAML::Value << m_rowWidth;
 	out << YAML::Key << "m_alleyDepth" << YAML::Value << m_alleyDepth;
+	out << YAML::Key << "m_tileSize" << YAML::Value << m_tileSize;
 
 	if (!m_noiseDescriptors.empty())
 	{
@@ -116,6 +326,8 @@ void FieldGround::Deserialize(const YAML::Node& in) {
 		m_rowWidth = in["m_rowWidth"].as<float>();
 	if (in["m_alleyDepth"])
 		m_alleyDepth = in["m_alleyDepth"].as<float>();
+	if (in["m_tileSize"])
+		m_tileSize = in["m_tileSize"].as<int>();
 
 
 	if (in["m_noiseDescriptors"])
@@ -131,6 +343,9 @@ void FieldGround::OnCreate() {
 	m_size = glm::ivec2(150);
 	m_rowWidth = 0.0f;
 	m_alleyDepth = 0.15f;
+	m_tileSize = 0;
+	m_heights.clear();
+	m_heightCacheStart = m_heightCacheSize = glm::ivec2(0);
 	m_noiseDescriptors.clear();
 	m_noiseDescriptors.emplace_back();
 }
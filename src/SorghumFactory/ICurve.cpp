@@ -40,19 +40,22 @@ glm::vec3 BezierCurve::GetEndAxis() const {
   return glm::normalize(m_p3 - m_p2);
 }
 BezierCurve::BezierCurve() {}
-void BezierSpline::Import(std::ifstream &stream) {
+bool BezierSpline::Import(TextTokenizer &tokenizer) {
   int curveAmount;
-  stream >> curveAmount;
+  if (!tokenizer.Read(curveAmount) || curveAmount < 0)
+    return false;
   m_curves.clear();
   for (int i = 0; i < curveAmount; i++) {
     glm::vec3 cp[4];
     float x, y, z;
     for (auto &j : cp) {
-      stream >> x >> z >> y;
+      if (!tokenizer.Read(x) || !tokenizer.Read(z) || !tokenizer.Read(y))
+        return false;
       j = glm::vec3(x, y, z);
     }
     m_curves.emplace_back(cp[0], cp[1], cp[2], cp[3]);
   }
+  return true;
 }
 glm::vec3 BezierSpline::EvaluatePointFromCurves(float point) const {
   const float splineU = glm::clamp(point, 0.0f, 1.0f) * float(m_curves.size());
@@ -2,6 +2,7 @@
 // Created by lllll on 3/13/2022.
 //
 #include "LeafData.hpp"
+#include "BinarySidecar.hpp"
 #include "DefaultResources.hpp"
 #include "Graphics.hpp"
 #include "ProceduralSorghum.hpp"
@@ -59,6 +60,9 @@ void LeafData::Serialize(YAML::Emitter &out) {
   out << YAML::Key << "m_branchingAngle" << YAML::Value << m_branchingAngle;
   out << YAML::Key << "m_rollAngle" << YAML::Value << m_rollAngle;
 
+  //Rebuilt from the plant on load.
+  if (SorghumData::IsLazyOrgan(GetScene(), GetOwner()))
+    return;
   out << YAML::Key << "m_curves" << YAML::BeginSeq;
   for (const auto &i : m_curves) {
     out << YAML::BeginMap;
@@ -70,11 +74,7 @@ void LeafData::Serialize(YAML::Emitter &out) {
   }
   out << YAML::EndSeq;
 
-  if (!m_nodes.empty()) {
-    out << YAML::Key << "m_nodes" << YAML::Value
-        << YAML::Binary((const unsigned char *)m_nodes.data(),
-                        m_nodes.size() * sizeof(SplineNode));
-  }
+  SaveListAsBinary<SplineNode>("m_nodes", m_nodes, out);
 }
 void LeafData::Deserialize(const YAML::Node &in) {
   if (in["m_left"])
@@ -99,11 +99,7 @@ void LeafData::Deserialize(const YAML::Node &in) {
     }
   }
 
-  if (in["m_nodes"]) {
-    YAML::Binary nodes = in["m_nodes"].as<YAML::Binary>();
-    m_nodes.resize(nodes.size() / sizeof(SplineNode));
-    std::memcpy(m_nodes.data(), nodes.data(), nodes.size());
-  }
+  LoadListFromBinary<SplineNode>("m_nodes", m_nodes, in);
 }
 void LeafData::GenerateLeafGeometry(const SorghumStatePair &sorghumStatePair,
                                     bool isBottomFace, float thickness) {
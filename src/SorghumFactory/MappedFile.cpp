@@ -0,0 +1,90 @@
+#include "MappedFile.hpp"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace EcoSysLab;
+
+MappedFile::MappedFile(const std::filesystem::path &path) { Open(path); }
+
+MappedFile::~MappedFile() { Close(); }
+
+bool MappedFile::Open(const std::filesystem::path &path) {
+  Close();
+#ifdef _WIN32
+  HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ,
+                            FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+  HANDLE mapping =
+      CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    CloseHandle(file);
+    return false;
+  }
+  void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!view) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+  m_fileHandle = file;
+  m_mappingHandle = mapping;
+  m_data = static_cast<const unsigned char *>(view);
+  m_size = static_cast<size_t>(size.QuadPart);
+#else
+  const int fileDescriptor = open(path.c_str(), O_RDONLY);
+  if (fileDescriptor == -1)
+    return false;
+  struct stat status {};
+  if (fstat(fileDescriptor, &status) != 0 || status.st_size == 0) {
+    close(fileDescriptor);
+    return false;
+  }
+  void *view = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE,
+                    fileDescriptor, 0);
+  if (view == MAP_FAILED) {
+    close(fileDescriptor);
+    return false;
+  }
+  m_fileDescriptor = fileDescriptor;
+  m_data = static_cast<const unsigned char *>(view);
+  m_size = static_cast<size_t>(status.st_size);
+#endif
+  return true;
+}
+
+void MappedFile::Close() {
+  if (!m_data)
+    return;
+#ifdef _WIN32
+  UnmapViewOfFile(m_data);
+  CloseHandle(m_mappingHandle);
+  CloseHandle(m_fileHandle);
+  m_mappingHandle = m_fileHandle = nullptr;
+#else
+  munmap(const_cast<unsigned char *>(m_data), m_size);
+  close(m_fileDescriptor);
+  m_fileDescriptor = -1;
+#endif
+  m_data = nullptr;
+  m_size = 0;
+}
+
+bool MappedFile::IsOpen() const { return m_data != nullptr; }
+
+const unsigned char *MappedFile::GetData() const { return m_data; }
+
+size_t MappedFile::GetSize() const { return m_size; }
@@ -3,6 +3,7 @@
 //
 #ifdef RAYTRACERFACILITY
 #include "PARSensorGroup.hpp"
+#include "BinarySidecar.hpp"
 #include "RayTracerLayer.hpp"
 #include "DefaultResources.hpp"
 #include "Graphics.hpp"
@@ -18,6 +19,8 @@ void EcoSysLab::PARSensorGroup::CalculateIllumination(
 }
 void PARSensorGroup::OnInspect() {
   ImGui::Text("Sampler size: %llu", m_samplers.size());
+  BinarySidecar::OnInspect(std::dynamic_pointer_cast<IAsset>(m_self.lock()),
+                           "PARSensorGroup", ".parsensorgroup");
   if (ImGui::TreeNode("Grid settings")) {
     static auto minRange = glm::vec3(-25, 0, -25);
     static auto maxRange = glm::vec3(25, 3, 25);
@@ -102,18 +105,9 @@ void PARSensorGroup::OnInspect() {
   }
 }
 void PARSensorGroup::Serialize(YAML::Emitter &out) {
-  if (!m_samplers.empty())
-  {
-    out << YAML::Key << "m_samplers" << YAML::Value
-        << YAML::Binary((const unsigned char *)m_samplers.data(), m_samplers.size() * sizeof(IlluminationSampler<float>));
-  }
+  SaveListAsBinary<IlluminationSampler<float>>("m_samplers", m_samplers, out);
 }
 void PARSensorGroup::Deserialize(const YAML::Node &in) {
-  if (in["m_samplers"])
-  {
-    auto binaryList = in["m_samplers"].as<YAML::Binary>();
-    m_samplers.resize(binaryList.size() / sizeof(IlluminationSampler<float>));
-    std::memcpy(m_samplers.data(), binaryList.data(), binaryList.size());
-  }
+  LoadListFromBinary<IlluminationSampler<float>>("m_samplers", m_samplers, in);
 }
 #endif
\ No newline at end of file
@@ -6,7 +6,8 @@
 #include "SorghumLayer.hpp"
 #include "SorghumStateGenerator.hpp"
 #include "Utilities.hpp"
-#include "rapidcsv.h"
+#include "CsvReader.hpp"
+#include "MappedFile.hpp"
 #include <utility>
 using namespace EcoSysLab;
 static const char *StateModes[]{"Default", "Cubic-Bezier"};
@@ -359,41 +360,12 @@ bool SorghumState::OnInspect(int mode) {
     FileUtils::OpenFile(
         "Import...", "TXT", {".txt"},
         [&](const std::filesystem::path &path) {
-          std::ifstream file(path, std::fstream::in);
-          if (!file.is_open()) {
-            UNIENGINE_LOG("Failed to open file!");
+          std::string error;
+          if (!ImportSkeleton(path, error)) {
+            UNIENGINE_ERROR(error);
             return;
           }
           changed = true;
-          // Number of leaves in the file
-          int leafCount;
-          file >> leafCount;
-          m_stem = ProceduralStemState();
-          m_stem.m_spline.Import(file);
-          /*
-          // Recenter plant:
-          glm::vec3 posSum = m_stem.m_spline.m_curves.front().m_p0;
-          for (auto &curve : m_stem.m_spline.m_curves) {
-            curve.m_p0 -= posSum;
-            curve.m_p1 -= posSum;
-            curve.m_p2 -= posSum;
-            curve.m_p3 -= posSum;
-          }
-          */
-          m_leaves.resize(leafCount);
-          for (int i = 0; i < leafCount; i++) {
-            float startingPoint;
-            file >> startingPoint;
-            m_leaves[i] = ProceduralLeafState();
-            m_leaves[i].m_startingPoint = startingPoint;
-            m_leaves[i].m_spline.Import(file);
-            m_leaves[i].m_spline.m_curves[0].m_p0 =
-                m_stem.m_spline.EvaluatePointFromCurves(startingPoint);
-          }
-
-          for (int i = 0; i < leafCount; i++) {
-            m_leaves[i].m_index = i;
-          }
         },
         false);
   }
@@ -402,6 +374,48 @@ bool SorghumState::OnInspect(int mode) {
   return changed;
 }
 
+bool SorghumState::ImportSkeleton(TextTokenizer &tokenizer) {
+  // Number of leaves in the file
+  int leafCount;
+  if (!tokenizer.Read(leafCount) || leafCount < 0)
+    return false;
+  ProceduralStemState stem;
+  if (!stem.m_spline.Import(tokenizer) || stem.m_spline.m_curves.empty())
+    return false;
+  std::vector<ProceduralLeafState> leaves;
+  for (int i = 0; i < leafCount; i++) {
+    float startingPoint;
+    if (!tokenizer.Read(startingPoint))
+      return false;
+    auto &leaf = leaves.emplace_back();
+    leaf.m_index = i;
+    leaf.m_startingPoint = startingPoint;
+    if (!leaf.m_spline.Import(tokenizer) || leaf.m_spline.m_curves.empty())
+      return false;
+    leaf.m_spline.m_curves[0].m_p0 =
+        stem.m_spline.EvaluatePointFromCurves(startingPoint);
+  }
+  m_stem = std::move(stem);
+  m_leaves = std::move(leaves);
+  return true;
+}
+
+bool SorghumState::ImportSkeleton(const std::filesystem::path &path,
+                                  std::string &error) {
+  MappedFile file;
+  if (!file.Open(path)) {
+    error = path.filename().string() + ": failed to open file!";
+    return false;
+  }
+  const auto *data = reinterpret_cast<const char *>(file.GetData());
+  TextTokenizer tokenizer(data, data + file.GetSize());
+  if (!ImportSkeleton(tokenizer)) {
+    error = path.filename().string() + ": malformed skeleton!";
+    return false;
+  }
+  return true;
+}
+
 void SorghumState::Serialize(YAML::Emitter &out) {
 
   out << YAML::Key << "m_version" << YAML::Value << m_version;
@@ -494,6 +508,23 @@ void ProceduralSorghum::OnInspect() {
       "Import CSV", "CSV", {".csv", ".CSV"},
       [&](const std::filesystem::path &path) { changed = ImportCSV(path); },
       false);
+  static std::vector<std::string> skeletonErrors;
+  FileUtils::OpenFolder(
+      "Import skeleton folder",
+      [&](const std::filesystem::path &path) {
+        const int amount = ImportSkeletons(path, skeletonErrors);
+        UNIENGINE_LOG("Imported " + std::to_string(amount) + " skeletons, " +
+                      std::to_string(skeletonErrors.size()) + " failed.");
+        changed = true;
+      },
+      false);
+  if (!skeletonErrors.empty() && ImGui::TreeNode("Skeleton import errors")) {
+    for (const auto &error : skeletonErrors)
+      ImGui::Text("%s", error.c_str());
+    if (ImGui::Button("Clear"))
+      skeletonErrors.clear();
+    ImGui::TreePop();
+  }
 
   if (ImGui::Combo("Mode", &m_mode, StateModes, IM_ARRAYSIZE(StateModes))) {
     changed = false;
@@ -693,21 +724,122 @@ float ProceduralSorghum::GetCurrentEndTime() const {
 
 unsigned ProceduralSorghum::GetVersion() const { return m_version; }
 
+//Orders numbered files naturally, skeleton_procedural_2 before skeleton_procedural_10.
+static bool NaturalLess(const std::string &l, const std::string &r) {
+  auto isDigit = [](char c) { return c >= '0' && c <= '9'; };
+  size_t i = 0, j = 0;
+  while (i < l.size() && j < r.size()) {
+    if (isDigit(l[i]) && isDigit(r[j])) {
+      while (i + 1 < l.size() && l[i] == '0' && isDigit(l[i + 1]))
+        i++;
+      while (j + 1 < r.size() && r[j] == '0' && isDigit(r[j + 1]))
+        j++;
+      size_t iEnd = i, jEnd = j;
+      while (iEnd < l.size() && isDigit(l[iEnd]))
+        iEnd++;
+      while (jEnd < r.size() && isDigit(r[jEnd]))
+        jEnd++;
+      if (iEnd - i != jEnd - j)
+        return iEnd - i < jEnd - j;
+      const int compare = l.compare(i, iEnd - i, r, j, jEnd - j);
+      if (compare != 0)
+        return compare < 0;
+      i = iEnd;
+      j = jEnd;
+      continue;
+    }
+    if (l[i] != r[j])
+      return l[i] < r[j];
+    i++;
+    j++;
+  }
+  return l.size() - i < r.size() - j;
+}
+
+int ProceduralSorghum::ImportSkeletons(const std::filesystem::path &folder,
+                                       std::vector<std::string> &errors) {
+  errors.clear();
+  std::vector<std::filesystem::path> paths;
+  std::error_code errorCode;
+  for (const auto &entry :
+       std::filesystem::directory_iterator(folder, errorCode)) {
+    const auto fileName = entry.path().filename().string();
+    if (entry.is_regular_file() && entry.path().extension() == ".txt" &&
+        fileName.rfind("skeleton_procedural_", 0) == 0)
+      paths.push_back(entry.path());
+  }
+  if (errorCode) {
+    errors.push_back(folder.string() + ": " + errorCode.message());
+    return 0;
+  }
+  std::sort(paths.begin(), paths.end(),
+            [](const std::filesystem::path &l, const std::filesystem::path &r) {
+              return NaturalLess(l.filename().string(),
+                                 r.filename().string());
+            });
+
+  std::vector<SorghumState> states(paths.size());
+  std::vector<std::string> fileErrors(paths.size());
+  std::vector<std::shared_future<void>> results;
+  Jobs::ParallelFor(
+      paths.size(),
+      [&](unsigned i) {
+        if (states[i].ImportSkeleton(paths[i], fileErrors[i]))
+          states[i].m_name = paths[i].stem().string();
+      },
+      results);
+  for (auto &i : results)
+    i.wait();
+
+  std::vector<std::pair<float, SorghumState>> sorghumStates;
+  for (int i = 0; i < paths.size(); i++) {
+    if (!fileErrors[i].empty()) {
+      errors.push_back(fileErrors[i]);
+      continue;
+    }
+    sorghumStates.emplace_back(static_cast<float>(sorghumStates.size()),
+                               std::move(states[i]));
+  }
+  // The current states are kept when nothing could be imported.
+  if (sorghumStates.empty()) {
+    if (errors.empty())
+      errors.push_back(folder.string() + ": no skeleton_procedural_*.txt files!");
+    return 0;
+  }
+  m_sorghumStates.swap(sorghumStates);
+  m_mode = (int)StateMode::CubicBezier;
+  m_saved = false;
+  m_version++;
+  return m_sorghumStates.size();
+}
+
 bool ProceduralSorghum::ImportCSV(const std::filesystem::path &filePath) {
   try {
-    rapidcsv::Document doc(filePath.string());
-    std::vector<std::string> timePoints =
-        doc.GetColumn<std::string>("Time Point");
-    std::vector<float> stemHeights = doc.GetColumn<float>("Stem Height");
-    std::vector<float> stemWidth = doc.GetColumn<float>("Stem Width");
-    std::vector<float> leafIndex = doc.GetColumn<float>("Leaf Number");
-    std::vector<float> leafLength = doc.GetColumn<float>("Leaf Length");
-    std::vector<float> leafWidth = doc.GetColumn<float>("Leaf Width");
-    std::vector<float> leafHeight = doc.GetColumn<float>("Leaf Height");
-    std::vector<float> startingPoint = doc.GetColumn<float>("Start Point");
-    std::vector<float> branchingAngle = doc.GetColumn<float>("Branching Angle");
-    std::vector<float> panicleLength = doc.GetColumn<float>("Panicle Height");
-    std::vector<float> panicleWidth = doc.GetColumn<float>("Panicle Width");
+    CsvReader reader;
+    if (!reader.Open(filePath))
+      return false;
+    std::vector<std::string> timePoints;
+    std::vector<float> stemHeights, stemWidth, leafIndex, leafLength, leafWidth,
+        leafHeight, startingPoint, branchingAngle, panicleLength, panicleWidth;
+    reader.Bind("Time Point", timePoints);
+    reader.Bind("Stem Height", stemHeights);
+    reader.Bind("Stem Width", stemWidth);
+    reader.Bind("Leaf Number", leafIndex);
+    reader.Bind("Leaf Length", leafLength);
+    reader.Bind("Leaf Width", leafWidth);
+    reader.Bind("Leaf Height", leafHeight);
+    reader.Bind("Start Point", startingPoint);
+    reader.Bind("Branching Angle", branchingAngle);
+    reader.Bind("Panicle Height", panicleLength);
+    reader.Bind("Panicle Width", panicleWidth);
+    if (!reader.Read())
+      return false;
+    for (const auto &i : leafIndex) {
+      if (!(i >= 1.0f)) {
+        UNIENGINE_ERROR("Invalid leaf number!");
+        return false;
+      }
+    }
 
     m_sorghumStates.clear();
 
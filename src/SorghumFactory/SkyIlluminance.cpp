@@ -1,8 +1,9 @@
 //
 // Created by lllll on 2/23/2022.
 //
-#include "rapidcsv.h"
 #include "SkyIlluminance.hpp"
+#include "CsvReader.hpp"
+#include "SolarPosition.hpp"
 #ifdef RAYTRACERFACILITY
 #include "RayTracerLayer.hpp"
 #endif
@@ -10,71 +11,387 @@
 #ifdef RAYTRACERFACILITY
 using namespace RayTracerFacility;
 #endif
-using namespace EcoSysLab;SkyIlluminanceSnapshot
-SkyIlluminanceSnapshotLerp(const SkyIlluminanceSnapshot &l,
-                           const SkyIlluminanceSnapshot &r, float a) {
-  if (a < 0.0f)
-    return l;
-  if (a > 1.0f)
-    return r;
+using namespace EcoSysLab;
+
+void SkyIlluminance::SetSnapshots(const std::vector<float> &times,
+                                  const std::vector<float> &ghis,
+                                  const std::vector<float> &azimuths,
+                                  const std::vector<float> &zeniths) {
+  assert(times.size() == ghis.size() && times.size() == azimuths.size() &&
+         times.size() == zeniths.size());
+  std::vector<size_t> order(times.size());
+  for (size_t i = 0; i < order.size(); i++)
+    order[i] = i;
+  std::stable_sort(order.begin(), order.end(),
+                   [&](size_t l, size_t r) { return times[l] < times[r]; });
+  m_times.clear();
+  m_ghis.clear();
+  m_azimuths.clear();
+  m_zeniths.clear();
+  for (const auto i : order) {
+    if (!m_times.empty() && m_times.back() == times[i]) {
+      m_ghis.back() = ghis[i];
+      m_azimuths.back() = azimuths[i];
+      m_zeniths.back() = zeniths[i];
+      continue;
+    }
+    m_times.push_back(times[i]);
+    m_ghis.push_back(ghis[i]);
+    m_azimuths.push_back(azimuths[i]);
+    m_zeniths.push_back(zeniths[i]);
+  }
+  m_sunDirections.resize(m_times.size());
+  for (size_t i = 0; i < m_times.size(); i++) {
+    m_sunDirections[i] = SkyIlluminanceSnapshot::ComputeSunDirection(
+        m_azimuths[i], m_zeniths[i]);
+  }
+  m_minTime = m_times.empty() ? 0 : m_times.front();
+  m_maxTime = m_times.empty() ? 0 : m_times.back();
+  m_uniformInterval = 0;
+  if (m_times.size() > 1) {
+    const float interval = m_times[1] - m_times[0];
+    bool uniform = true;
+    for (size_t i = 1; i < m_times.size() && uniform; i++) {
+      uniform = glm::abs(m_times[i] - m_times[0] - interval * i) <=
+                interval * 1e-3f;
+    }
+    if (uniform)
+      m_uniformInterval = interval;
+  }
+  BuildIntegrals();
+}
+
+int SkyIlluminance::GetBinIndex(float azimuth, float zenith) const {
+  if (zenith >= 90.0f)
+    return -1;
+  azimuth = glm::mod(azimuth, 360.0f);
+  const int azimuthBin = glm::clamp(
+      static_cast<int>(azimuth / 360.0f * m_azimuthBinAmount), 0,
+      m_azimuthBinAmount - 1);
+  const int zenithBin =
+      glm::clamp(static_cast<int>(zenith / 90.0f * m_zenithBinAmount), 0,
+                 m_zenithBinAmount - 1);
+  return zenithBin * m_azimuthBinAmount + azimuthBin;
+}
+
+void SkyIlluminance::BuildIntegrals() {
+  m_azimuthBinAmount = glm::max(m_azimuthBinAmount, 1);
+  m_zenithBinAmount = glm::max(m_zenithBinAmount, 1);
+  const size_t segmentAmount = m_times.empty() ? 0 : m_times.size() - 1;
+  m_ghiIntegrals.resize(m_times.size());
+  m_segmentDirections.resize(segmentAmount);
+  m_segmentBins.resize(segmentAmount);
+  m_binSegments.clear();
+  m_binSegments.resize(m_azimuthBinAmount * m_zenithBinAmount);
+  m_binEnergyIntegrals.clear();
+  m_binEnergyIntegrals.resize(m_binSegments.size(), std::vector<double>(1, 0.0));
+  m_binDirectionIntegrals.clear();
+  m_binDirectionIntegrals.resize(m_binSegments.size(),
+                                 std::vector<glm::dvec3>(1, glm::dvec3(0.0)));
+  if (m_times.empty())
+    return;
+  m_ghiIntegrals[0] = 0;
+  for (size_t i = 0; i < segmentAmount; i++) {
+    const double energy = IntegrateSegment(i, m_times[i], m_times[i + 1]);
+    m_ghiIntegrals[i + 1] = m_ghiIntegrals[i] + energy;
+    //Halfway along the shorter arc, so a segment crossing north stays in one piece.
+    float azimuthDifference = glm::mod(m_azimuths[i + 1] - m_azimuths[i], 360.0f);
+    if (azimuthDifference > 180.0f)
+      azimuthDifference -= 360.0f;
+    const float azimuth = m_azimuths[i] + azimuthDifference * 0.5f;
+    const float zenith = (m_zeniths[i] + m_zeniths[i + 1]) * 0.5f;
+    const auto direction = m_sunDirections[i] + m_sunDirections[i + 1];
+    m_segmentDirections[i] = glm::length(direction) > 0.0f
+                                 ? glm::normalize(direction)
+                                 : m_sunDirections[i];
+    const int bin = GetBinIndex(azimuth, zenith);
+    m_segmentBins[i] = bin;
+    if (bin == -1)
+      continue;
+    m_binSegments[bin].push_back(static_cast<unsigned>(i));
+    m_binEnergyIntegrals[bin].push_back(m_binEnergyIntegrals[bin].back() +
+                                        energy);
+    m_binDirectionIntegrals[bin].push_back(
+        m_binDirectionIntegrals[bin].back() +
+        glm::dvec3(m_segmentDirections[i]) * energy);
+  }
+}
+
+double SkyIlluminance::IntegrateSegment(size_t segment, float startTime,
+                                        float endTime) const {
+  const double length = m_times[segment + 1] - m_times[segment];
+  if (length <= 0.0 || endTime <= startTime)
+    return 0.0;
+  const double startGhi =
+      glm::mix(static_cast<double>(m_ghis[segment]),
+               static_cast<double>(m_ghis[segment + 1]),
+               (startTime - m_times[segment]) / length);
+  const double endGhi = glm::mix(static_cast<double>(m_ghis[segment]),
+                                 static_cast<double>(m_ghis[segment + 1]),
+                                 (endTime - m_times[segment]) / length);
+  return (static_cast<double>(endTime) - startTime) * (startGhi + endGhi) *
+         0.5;
+}
+
+double SkyIlluminance::GetIntegral(float time) const {
+  if (m_times.size() < 2)
+    return 0.0;
+  size_t index;
+  float weight;
+  Locate(time, index, weight);
+  return m_ghiIntegrals[index] +
+         IntegrateSegment(index, m_times[index],
+                          glm::clamp(time, m_times[index], m_times[index + 1]));
+}
+
+float SkyIlluminance::Integrate(float startTime, float endTime) const {
+  return static_cast<float>(GetIntegral(endTime) - GetIntegral(startTime));
+}
+
+void SkyIlluminance::GetSunDirectionHistogram(
+    float startTime, float endTime, std::vector<SunDirectionBin> &bins) const {
+  bins.clear();
+  if (m_times.size() < 2)
+    return;
+  startTime = glm::clamp(startTime, m_minTime, m_maxTime);
+  endTime = glm::clamp(endTime, m_minTime, m_maxTime);
+  if (endTime <= startTime)
+    return;
+  std::vector<double> energies(m_binSegments.size(), 0.0);
+  std::vector<glm::dvec3> directions(m_binSegments.size(), glm::dvec3(0.0));
+  auto addPartial = [&](size_t segment, float start, float end) {
+    const int bin = m_segmentBins[segment];
+    if (bin == -1)
+      return;
+    const double energy = IntegrateSegment(segment, start, end);
+    energies[bin] += energy;
+    directions[bin] += glm::dvec3(m_segmentDirections[segment]) * energy;
+  };
+  size_t startSegment, endSegment;
+  float weight;
+  Locate(startTime, startSegment, weight);
+  Locate(endTime, endSegment, weight);
+  if (startSegment == endSegment) {
+    addPartial(startSegment, startTime, endTime);
+  } else {
+    addPartial(startSegment, startTime, m_times[startSegment + 1]);
+    addPartial(endSegment, m_times[endSegment], endTime);
+    //Whole segments in between come from the prefix sums.
+    for (size_t bin = 0; bin < m_binSegments.size(); bin++) {
+      const auto &segments = m_binSegments[bin];
+      if (segments.empty())
+        continue;
+      const size_t first =
+          std::lower_bound(segments.begin(), segments.end(),
+                           static_cast<unsigned>(startSegment + 1)) -
+          segments.begin();
+      const size_t last =
+          std::lower_bound(segments.begin(), segments.end(),
+                           static_cast<unsigned>(endSegment)) -
+          segments.begin();
+      if (first >= last)
+        continue;
+      energies[bin] +=
+          m_binEnergyIntegrals[bin][last] - m_binEnergyIntegrals[bin][first];
+      directions[bin] += m_binDirectionIntegrals[bin][last] -
+                         m_binDirectionIntegrals[bin][first];
+    }
+  }
+  for (size_t bin = 0; bin < energies.size(); bin++) {
+    if (energies[bin] <= 0.0)
+      continue;
+    SunDirectionBin sunDirectionBin;
+    sunDirectionBin.m_direction = glm::normalize(glm::vec3(directions[bin]));
+    sunDirectionBin.m_energy = static_cast<float>(energies[bin]);
+    bins.push_back(sunDirectionBin);
+  }
+}
+
+size_t SkyIlluminance::GetSnapshotAmount() const { return m_times.size(); }
+
+float SkyIlluminance::GetSnapshotTime(size_t index) const {
+  return m_times[index];
+}
+
+SkyIlluminanceSnapshot SkyIlluminance::GetSnapshot(size_t index) const {
   SkyIlluminanceSnapshot snapshot;
-  snapshot.m_ghi = l.m_ghi * a + r.m_ghi * (1.0f - a);
-  snapshot.m_azimuth = l.m_azimuth * a + r.m_azimuth * (1.0f - a);
-  snapshot.m_zenith = l.m_zenith * a + r.m_zenith * (1.0f - a);
+  snapshot.m_ghi = m_ghis[index];
+  snapshot.m_azimuth = m_azimuths[index];
+  snapshot.m_zenith = m_zeniths[index];
+  snapshot.m_sunDirection = m_sunDirections[index];
   return snapshot;
 }
 
-SkyIlluminanceSnapshot SkyIlluminance::Get(float time) {
-  if (m_snapshots.empty()) {
+void SkyIlluminance::Locate(float time, size_t &index, float &weight) const {
+  const size_t last = m_times.size() - 1;
+  if (last == 0 || time <= m_times.front()) {
+    index = 0;
+    weight = 0;
+    return;
+  }
+  if (time >= m_times.back()) {
+    index = last - 1;
+    weight = 1;
+    return;
+  }
+  if (m_uniformInterval > 0) {
+    const float position = (time - m_times.front()) / m_uniformInterval;
+    index = glm::min(static_cast<size_t>(position), last - 1);
+  } else {
+    index = std::upper_bound(m_times.begin(), m_times.end(), time) -
+            m_times.begin() - 1;
+  }
+  weight = glm::clamp((time - m_times[index]) /
+                          (m_times[index + 1] - m_times[index]),
+                      0.0f, 1.0f);
+}
+
+SkyIlluminanceSnapshot SkyIlluminance::Get(float time) const {
+  if (m_times.empty()) {
     return {};
   }
-  if (time <= m_snapshots.begin()->first)
-    return m_snapshots.begin()->second;
-  SkyIlluminanceSnapshot lastShot;
-  lastShot = m_snapshots.begin()->second;
-  float lastTime = m_snapshots.begin()->first;
-  for (const auto &pair : m_snapshots) {
-    if (time < pair.first) {
-      if (pair.first - lastTime == 0)
-        return lastShot;
-      return SkyIlluminanceSnapshotLerp(
-          lastShot, pair.second, (time - lastTime) / (pair.first - lastTime));
-    }
-    lastShot = pair.second;
-    lastTime = pair.first;
+  size_t index;
+  float weight;
+  Locate(time, index, weight);
+  if (weight == 0 || (m_computeSunPosition && weight == 1))
+    return GetSnapshot(weight == 0 ? index : index + 1);
+  SkyIlluminanceSnapshot snapshot;
+  snapshot.m_ghi = glm::mix(m_ghis[index], m_ghis[index + 1], weight);
+  snapshot.m_azimuth =
+      glm::mix(m_azimuths[index], m_azimuths[index + 1], weight);
+  snapshot.m_zenith = glm::mix(m_zeniths[index], m_zeniths[index + 1], weight);
+  if (m_computeSunPosition) {
+    SolarPosition::Compute(m_latitude, m_longitude, GetJulianDay(time),
+                           snapshot.m_azimuth, snapshot.m_zenith);
+    snapshot.m_sunDirection = SkyIlluminanceSnapshot::ComputeSunDirection(
+        snapshot.m_azimuth, snapshot.m_zenith);
+    return snapshot;
   }
-  return std::prev(m_snapshots.end())->second;
+  snapshot.m_sunDirection = glm::normalize(
+      glm::mix(m_sunDirections[index], m_sunDirections[index + 1], weight));
+  return snapshot;
 }
-void SkyIlluminance::ImportCSV(const std::filesystem::path& path) {
-  rapidcsv::Document doc(path.string());
-  std::vector<float> timeSeries = doc.GetColumn<float>("Time");
-  std::vector<float> ghiSeries = doc.GetColumn<float>("SunLightDensity");
-  std::vector<float> azimuthSeries = doc.GetColumn<float>("Azimuth");
-  std::vector<float> zenithSeries = doc.GetColumn<float>("Zenith");
-  assert(timeSeries.size() == ghiSeries.size() && azimuthSeries.size() == zenithSeries.size() && timeSeries.size() == azimuthSeries.size());
-  m_snapshots.clear();
-  m_maxTime = 0;
-  m_minTime = 999999;
-  for(int i = 0; i < timeSeries.size(); i++) {
-    SkyIlluminanceSnapshot snapshot;
-    snapshot.m_ghi = ghiSeries[i];
-    snapshot.m_azimuth = azimuthSeries[i];
-    snapshot.m_zenith = zenithSeries[i];
-    auto time = timeSeries[i];
-    m_snapshots[time] = snapshot;
-    if (m_maxTime < time) {
-      m_maxTime = time;
-    }
-    if (m_minTime > time) {
-      m_minTime = time;
+
+void SkyIlluminance::GetBatch(
+    const std::vector<float> &times,
+    std::vector<SkyIlluminanceSnapshot> &snapshots) const {
+  snapshots.resize(times.size());
+  if (m_times.empty()) {
+    std::fill(snapshots.begin(), snapshots.end(), SkyIlluminanceSnapshot());
+    return;
+  }
+  if (m_times.size() == 1) {
+    std::fill(snapshots.begin(), snapshots.end(), GetSnapshot(0));
+    return;
+  }
+  //Locate everything first so the interpolation below is a straight loop over plain arrays.
+  std::vector<size_t> indices(times.size());
+  std::vector<float> weights(times.size());
+  for (size_t i = 0; i < times.size(); i++) {
+    Locate(times[i], indices[i], weights[i]);
+  }
+  for (size_t i = 0; i < times.size(); i++) {
+    const size_t l = indices[i];
+    const float a = weights[i];
+    auto &snapshot = snapshots[i];
+    snapshot.m_ghi = m_ghis[l] + (m_ghis[l + 1] - m_ghis[l]) * a;
+    snapshot.m_azimuth =
+        m_azimuths[l] + (m_azimuths[l + 1] - m_azimuths[l]) * a;
+    snapshot.m_zenith = m_zeniths[l] + (m_zeniths[l + 1] - m_zeniths[l]) * a;
+    snapshot.m_sunDirection =
+        m_sunDirections[l] + (m_sunDirections[l + 1] - m_sunDirections[l]) * a;
+  }
+  if (m_computeSunPosition) {
+    std::vector<double> julianDays(times.size());
+    for (size_t i = 0; i < times.size(); i++)
+      julianDays[i] = GetJulianDay(glm::clamp(times[i], m_minTime, m_maxTime));
+    std::vector<float> azimuths, zeniths;
+    SolarPosition::Compute(m_latitude, m_longitude, julianDays, azimuths,
+                           zeniths);
+    for (size_t i = 0; i < times.size(); i++) {
+      auto &snapshot = snapshots[i];
+      snapshot.m_azimuth = azimuths[i];
+      snapshot.m_zenith = zeniths[i];
+      snapshot.m_sunDirection = SkyIlluminanceSnapshot::ComputeSunDirection(
+          azimuths[i], zeniths[i]);
     }
+    return;
   }
+  for (auto &snapshot : snapshots) {
+    snapshot.m_sunDirection = glm::normalize(snapshot.m_sunDirection);
+  }
+}
+
+double SkyIlluminance::GetJulianDay(float time) const {
+  return SolarPosition::GetJulianDay(m_startDate.x, m_startDate.y,
+                                     m_startDate.z) +
+         time / 1440.0;
+}
 
+void SkyIlluminance::ComputeSunPositions() {
+  std::vector<double> julianDays(m_times.size());
+  for (size_t i = 0; i < m_times.size(); i++)
+    julianDays[i] = GetJulianDay(m_times[i]);
+  std::vector<float> azimuths, zeniths;
+  SolarPosition::Compute(m_latitude, m_longitude, julianDays, azimuths,
+                         zeniths);
+  const auto times = m_times;
+  const auto ghis = m_ghis;
+  SetSnapshots(times, ghis, azimuths, zeniths);
+}
+
+void SkyIlluminance::ImportCSV(const std::filesystem::path& path) {
+  CsvReader reader;
+  if (!reader.Open(path)) {
+    UNIENGINE_ERROR("Can't open file!");
+    return;
+  }
+  std::vector<float> timeSeries, ghiSeries, azimuthSeries, zenithSeries;
+  reader.Bind("Time", timeSeries);
+  reader.Bind("SunLightDensity", ghiSeries);
+  //GHI only files get their sun positions from the solar model.
+  const bool hasSunPosition = reader.GetColumnIndex("Azimuth") != -1 &&
+                              reader.GetColumnIndex("Zenith") != -1;
+  if (hasSunPosition && !m_computeSunPosition) {
+    reader.Bind("Azimuth", azimuthSeries);
+    reader.Bind("Zenith", zenithSeries);
+  }
+  if (!reader.Read())
+    return;
+  if (!hasSunPosition)
+    m_computeSunPosition = true;
+  if (m_computeSunPosition) {
+    std::vector<double> julianDays(timeSeries.size());
+    for (size_t i = 0; i < timeSeries.size(); i++)
+      julianDays[i] = GetJulianDay(timeSeries[i]);
+    SolarPosition::Compute(m_latitude, m_longitude, julianDays, azimuthSeries,
+                           zenithSeries);
+  }
+  SetSnapshots(timeSeries, ghiSeries, azimuthSeries, zenithSeries);
 }
 void SkyIlluminance::OnInspect() {
   FileUtils::OpenFile("Import CSV", "CSV", {".csv"}, [&](const std::filesystem::path &path){
     ImportCSV(path);
   }, false);
+  ImGui::Text("Snapshots: %d", static_cast<int>(m_times.size()));
+  if (m_uniformInterval > 0)
+    ImGui::Text("Interval: %.3f", m_uniformInterval);
+  if (ImGui::DragInt("Azimuth bins", &m_azimuthBinAmount, 1, 1, 360) |
+      ImGui::DragInt("Zenith bins", &m_zenithBinAmount, 1, 1, 90)) {
+    BuildIntegrals();
+  }
+  if (ImGui::TreeNode("Solar model")) {
+    ImGui::Checkbox("Compute sun position", &m_computeSunPosition);
+    ImGui::InputDouble("Latitude", &m_latitude);
+    ImGui::InputDouble("Longitude", &m_longitude);
+    ImGui::InputInt3("Start date (UTC)", &m_startDate.x);
+    if (ImGui::Button("Recompute snapshots"))
+      ComputeSunPositions();
+    ImGui::TreePop();
+  }
+  static glm::vec2 window = glm::vec2(0, 1440);
+  ImGui::DragFloat2("Integration window", &window.x);
+  ImGui::Text("Integrated GHI: %.3f", Integrate(window.x, window.y));
   static float time;
   static SkyIlluminanceSnapshot snapshot;
   static bool autoApply = false;
@@ -97,14 +414,20 @@ void SkyIlluminance::OnInspect() {
 void SkyIlluminance::Serialize(YAML::Emitter &out) {
   out << YAML::Key << "m_minTime" << YAML::Value << m_minTime;
   out << YAML::Key << "m_maxTime" << YAML::Value << m_maxTime;
-  if(!m_snapshots.empty()) {
+  out << YAML::Key << "m_azimuthBinAmount" << YAML::Value << m_azimuthBinAmount;
+  out << YAML::Key << "m_zenithBinAmount" << YAML::Value << m_zenithBinAmount;
+  out << YAML::Key << "m_computeSunPosition" << YAML::Value << m_computeSunPosition;
+  out << YAML::Key << "m_latitude" << YAML::Value << m_latitude;
+  out << YAML::Key << "m_longitude" << YAML::Value << m_longitude;
+  out << YAML::Key << "m_startDate" << YAML::Value << m_startDate;
+  if(!m_times.empty()) {
     out << YAML::Key << "m_snapshots" << YAML::Value << YAML::BeginSeq;
-    for (const auto &pair : m_snapshots) {
+    for (size_t i = 0; i < m_times.size(); i++) {
       out << YAML::BeginMap;
-      out << YAML::Key << "time" << YAML::Value << pair.first;
-      out << YAML::Key << "m_ghi" << YAML::Value << pair.second.m_ghi;
-      out << YAML::Key << "m_azimuth" << YAML::Value << pair.second.m_azimuth;
-      out << YAML::Key << "m_zenith" << YAML::Value << pair.second.m_zenith;
+      out << YAML::Key << "time" << YAML::Value << m_times[i];
+      out << YAML::Key << "m_ghi" << YAML::Value << m_ghis[i];
+      out << YAML::Key << "m_azimuth" << YAML::Value << m_azimuths[i];
+      out << YAML::Key << "m_zenith" << YAML::Value << m_zeniths[i];
       out << YAML::EndMap;
     }
     out << YAML::EndSeq;
@@ -113,19 +436,30 @@ void SkyIlluminance::Serialize(YAML::Emitter &out) {
 void SkyIlluminance::Deserialize(const YAML::Node &in) {
   if(in["m_minTime"]) m_minTime = in["m_minTime"].as<float>();
   if(in["m_maxTime"]) m_maxTime = in["m_maxTime"].as<float>();
+  if(in["m_azimuthBinAmount"]) m_azimuthBinAmount = in["m_azimuthBinAmount"].as<int>();
+  if(in["m_zenithBinAmount"]) m_zenithBinAmount = in["m_zenithBinAmount"].as<int>();
+  if(in["m_computeSunPosition"]) m_computeSunPosition = in["m_computeSunPosition"].as<bool>();
+  if(in["m_latitude"]) m_latitude = in["m_latitude"].as<double>();
+  if(in["m_longitude"]) m_longitude = in["m_longitude"].as<double>();
+  if(in["m_startDate"]) m_startDate = in["m_startDate"].as<glm::ivec3>();
   if(in["m_snapshots"]) {
-    m_snapshots.clear();
+    std::vector<float> times, ghis, azimuths, zeniths;
     for(const auto& data : in["m_snapshots"]){
-      SkyIlluminanceSnapshot snapshot;
-      snapshot.m_ghi = data["m_ghi"].as<float>();
-      snapshot.m_azimuth = data["m_azimuth"].as<float>();
-      snapshot.m_zenith = data["m_zenith"].as<float>();
-      m_snapshots[data["time"].as<float>()] = snapshot;
+      times.push_back(data["time"].as<float>());
+      ghis.push_back(data["m_ghi"].as<float>());
+      azimuths.push_back(data["m_azimuth"].as<float>());
+      zeniths.push_back(data["m_zenith"].as<float>());
     }
+    SetSnapshots(times, ghis, azimuths, zeniths);
   }
 }
 
-glm::vec3 SkyIlluminanceSnapshot::GetSunDirection() {
-  return glm::quat(glm::radians(glm::vec3(90.0f - m_zenith, m_azimuth, 0))) * glm::vec3(0, 0, -1);
+glm::vec3 SkyIlluminanceSnapshot::ComputeSunDirection(float azimuth,
+                                                      float zenith) {
+  return glm::quat(glm::radians(glm::vec3(90.0f - zenith, azimuth, 0))) *
+         glm::vec3(0, 0, -1);
+}
+glm::vec3 SkyIlluminanceSnapshot::GetSunDirection() const {
+  return m_sunDirection;
 }
-float SkyIlluminanceSnapshot::GetSunIntensity() { return m_ghi; }
+float SkyIlluminanceSnapshot::GetSunIntensity() const { return m_ghi; }
@@ -0,0 +1,129 @@
+#include "SolarPosition.hpp"
+
+using namespace EcoSysLab;
+
+double SolarPosition::GetJulianDay(int year, int month, int day, double hour) {
+  if (month <= 2) {
+    year -= 1;
+    month += 12;
+  }
+  const int a = year / 100;
+  const int b = 2 - a + a / 4;
+  return glm::floor(365.25 * (year + 4716)) +
+         glm::floor(30.6001 * (month + 1)) + day + b - 1524.5 + hour / 24.0;
+}
+
+void SolarPosition::Compute(double latitude, double longitude,
+                            double julianDay, float &azimuth, float &zenith) {
+  const double century = (julianDay - 2451545.0) / 36525.0;
+  const double meanLongitude = glm::mod(
+      280.46646 + century * (36000.76983 + century * 0.0003032), 360.0);
+  const double meanAnomaly =
+      glm::radians(357.52911 + century * (35999.05029 - 0.0001537 * century));
+  const double eccentricity =
+      0.016708634 - century * (0.000042037 + 0.0000001267 * century);
+  const double equationOfCenter =
+      glm::sin(meanAnomaly) *
+          (1.914602 - century * (0.004817 + 0.000014 * century)) +
+      glm::sin(2.0 * meanAnomaly) * (0.019993 - 0.000101 * century) +
+      glm::sin(3.0 * meanAnomaly) * 0.000289;
+  const double omega = glm::radians(125.04 - 1934.136 * century);
+  const double apparentLongitude = glm::radians(
+      meanLongitude + equationOfCenter - 0.00569 - 0.00478 * glm::sin(omega));
+  const double meanObliquity =
+      23.0 +
+      (26.0 +
+       (21.448 -
+        century * (46.815 + century * (0.00059 - century * 0.001813))) /
+           60.0) /
+          60.0;
+  const double obliquity =
+      glm::radians(meanObliquity + 0.00256 * glm::cos(omega));
+  const double declination =
+      glm::asin(glm::sin(obliquity) * glm::sin(apparentLongitude));
+
+  const double y = glm::pow(glm::tan(obliquity * 0.5), 2.0);
+  const double l = glm::radians(meanLongitude);
+  //In minutes.
+  const double equationOfTime =
+      4.0 * glm::degrees(y * glm::sin(2.0 * l) -
+                         2.0 * eccentricity * glm::sin(meanAnomaly) +
+                         4.0 * eccentricity * y * glm::sin(meanAnomaly) *
+                             glm::cos(2.0 * l) -
+                         0.5 * y * y * glm::sin(4.0 * l) -
+                         1.25 * eccentricity * eccentricity *
+                             glm::sin(2.0 * meanAnomaly));
+  const double dayFraction = julianDay + 0.5 - glm::floor(julianDay + 0.5);
+  const double trueSolarTime =
+      glm::mod(dayFraction * 1440.0 + equationOfTime + 4.0 * longitude, 1440.0);
+  const double hourAngle = glm::radians(trueSolarTime * 0.25 - 180.0);
+
+  const double phi = glm::radians(latitude);
+  const double cosZenith = glm::clamp(
+      glm::sin(phi) * glm::sin(declination) +
+          glm::cos(phi) * glm::cos(declination) * glm::cos(hourAngle),
+      -1.0, 1.0);
+  const double geometricZenith = glm::acos(cosZenith);
+
+  //Clockwise from north first.
+  double clockwiseAzimuth = 0.0;
+  const double denominator = glm::cos(phi) * glm::sin(geometricZenith);
+  if (glm::abs(denominator) > 1e-9) {
+    const double a = glm::degrees(glm::acos(glm::clamp(
+        (glm::sin(phi) * cosZenith - glm::sin(declination)) / denominator,
+        -1.0, 1.0)));
+    clockwiseAzimuth =
+        hourAngle > 0.0 ? glm::mod(a + 180.0, 360.0) : glm::mod(540.0 - a, 360.0);
+  }
+  azimuth = static_cast<float>(clockwiseAzimuth > 180.0
+                                   ? 360.0 - clockwiseAzimuth
+                                   : -clockwiseAzimuth);
+  if (azimuth == -180.0f)
+    azimuth = 180.0f;
+
+  const double elevation = 90.0 - glm::degrees(geometricZenith);
+  double refraction = 0.0;
+  if (elevation <= 85.0) {
+    const double t = glm::tan(glm::radians(elevation));
+    if (elevation > 5.0)
+      refraction = 58.1 / t - 0.07 / (t * t * t) + 0.000086 / glm::pow(t, 5.0);
+    else if (elevation > -0.575)
+      refraction =
+          1735.0 +
+          elevation *
+              (-518.2 +
+               elevation * (103.4 + elevation * (-12.79 + elevation * 0.711)));
+    else
+      refraction = -20.772 / t;
+  }
+  zenith = static_cast<float>(glm::degrees(geometricZenith) -
+                              refraction / 3600.0);
+}
+
+void SolarPosition::Compute(double latitude, double longitude,
+                            const std::vector<double> &julianDays,
+                            std::vector<float> &azimuths,
+                            std::vector<float> &zeniths) {
+  azimuths.resize(julianDays.size());
+  zeniths.resize(julianDays.size());
+  const size_t blockSize = 4096;
+  const size_t blockAmount = (julianDays.size() + blockSize - 1) / blockSize;
+  if (blockAmount <= 1) {
+    for (size_t i = 0; i < julianDays.size(); i++)
+      Compute(latitude, longitude, julianDays[i], azimuths[i], zeniths[i]);
+    return;
+  }
+  std::vector<std::shared_future<void>> results;
+  Jobs::ParallelFor(
+      blockAmount,
+      [&](unsigned blockIndex) {
+        const size_t end =
+            glm::min((blockIndex + 1) * blockSize, julianDays.size());
+        for (size_t i = blockIndex * blockSize; i < end; i++)
+          Compute(latitude, longitude, julianDays[i], azimuths[i],
+                  zeniths[i]);
+      },
+      results);
+  for (auto &i : results)
+    i.wait();
+}
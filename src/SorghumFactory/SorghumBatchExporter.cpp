@@ -0,0 +1,146 @@
+#include "SorghumBatchExporter.hpp"
+#include "LeafData.hpp"
+#include "PanicleData.hpp"
+#include "SorghumLayer.hpp"
+#include "SorghumStateGenerator.hpp"
+#include "StemData.hpp"
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+using namespace EcoSysLab;
+
+//Organs formed outside of any scene.
+struct BatchPlant {
+  unsigned m_seed = 0;
+  std::shared_ptr<StemData> m_stem;
+  std::vector<std::shared_ptr<LeafData>> m_leaves;
+  std::shared_ptr<PanicleData> m_panicle;
+};
+
+bool SorghumBatchExporter::Export(
+    const std::shared_ptr<SorghumStateGenerator> &generator,
+    const std::filesystem::path &folder) const {
+  if (!generator) {
+    UNIENGINE_ERROR("No descriptor!");
+    return false;
+  }
+  // Subdivision settings are read from the layer.
+  if (!Application::GetLayer<SorghumLayer>()) {
+    UNIENGINE_ERROR("No sorghum layer!");
+    return false;
+  }
+  std::error_code errorCode;
+  std::filesystem::create_directories(folder, errorCode);
+  const std::string extension =
+      m_format == SorghumMeshFormat::Ply ? ".ply" : ".glb";
+  const size_t capacity = glm::max(1, m_queueSize);
+
+  std::mutex mutex;
+  std::condition_variable produced;
+  std::condition_variable consumed;
+  std::deque<std::unique_ptr<BatchPlant>> queue;
+  bool finished = false;
+  std::atomic<int> failed{0};
+  std::vector<std::thread> writers;
+  for (int i = 0; i < glm::max(1, m_writerAmount); i++) {
+    writers.emplace_back([&]() {
+      SorghumMeshWriter writer;
+      SorghumPlantMesh plantMesh;
+      while (true) {
+        std::unique_ptr<BatchPlant> plant;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          produced.wait(lock, [&]() { return finished || !queue.empty(); });
+          if (queue.empty())
+            return;
+          plant = std::move(queue.front());
+          queue.pop_front();
+        }
+        consumed.notify_one();
+        plantMesh.m_organs.clear();
+        plantMesh.m_organs.push_back({&plant->m_stem->m_vertices,
+                                      &plant->m_stem->m_triangles,
+                                      SorghumOrganType::Stem, 0});
+        for (const auto &leaf : plant->m_leaves) {
+          plantMesh.m_organs.push_back(
+              {&leaf->m_vertices, &leaf->m_triangles, SorghumOrganType::Leaf,
+               static_cast<unsigned short>(leaf->m_index + 1)});
+        }
+        plantMesh.m_organs.push_back({&plant->m_panicle->m_vertices,
+                                      &plant->m_panicle->m_triangles,
+                                      SorghumOrganType::Panicle, 0});
+        const auto path =
+            folder / (m_prefix + std::to_string(plant->m_seed) + extension);
+        if (!writer.Open(path, m_format)) {
+          failed++;
+          continue;
+        }
+        writer.Write(plantMesh);
+        if (!writer.Close())
+          failed++;
+      }
+    });
+  }
+
+  for (unsigned seed = m_seedStart; seed < m_seedEnd; seed++) {
+    // Same steps as SorghumData::FormPlant, so a seed gives the same plant as in the scene.
+    SorghumStatePair statePair;
+    statePair.m_right = statePair.m_left = generator->Generate(seed);
+    statePair.m_a = 1.0f;
+    auto plant = std::make_unique<BatchPlant>();
+    plant->m_seed = seed;
+    plant->m_stem = std::make_shared<StemData>();
+    plant->m_stem->FormStem(statePair, m_skeleton);
+    const auto leafSize = statePair.GetLeafSize();
+    plant->m_leaves.resize(leafSize);
+    for (int i = 0; i < leafSize; i++) {
+      auto &leaf = plant->m_leaves[i] = std::make_shared<LeafData>();
+      leaf->m_index = i;
+      leaf->FormLeaf(statePair, m_skeleton);
+    }
+    plant->m_panicle = std::make_shared<PanicleData>();
+    plant->m_panicle->FormPanicle(statePair);
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      consumed.wait(lock, [&]() { return queue.size() < capacity; });
+      queue.push_back(std::move(plant));
+    }
+    produced.notify_one();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+  }
+  produced.notify_all();
+  for (auto &writer : writers)
+    writer.join();
+
+  if (failed > 0) {
+    UNIENGINE_ERROR(std::to_string(failed.load()) + " meshes failed to export!");
+    return false;
+  }
+  UNIENGINE_LOG("Exported " + std::to_string(m_seedEnd - m_seedStart) +
+                " meshes to " + folder.string());
+  return true;
+}
+
+void SorghumBatchExporter::OnInspect(
+    const std::shared_ptr<SorghumStateGenerator> &generator) {
+  static const char *MeshFormats[]{"PLY", "GLB"};
+  int seedRange[2] = {(int)m_seedStart, (int)m_seedEnd};
+  if (ImGui::DragInt2("Seed range", seedRange, 1, 0, INT_MAX)) {
+    m_seedStart = seedRange[0];
+    m_seedEnd = glm::max(seedRange[0], seedRange[1]);
+  }
+  int format = (int)m_format;
+  if (ImGui::Combo("Format", &format, MeshFormats, IM_ARRAYSIZE(MeshFormats)))
+    m_format = (SorghumMeshFormat)format;
+  ImGui::DragInt("Queue size", &m_queueSize, 1, 1, 1024);
+  ImGui::DragInt("Writer threads", &m_writerAmount, 1, 1, 64);
+  ImGui::Checkbox("Skeleton", &m_skeleton);
+  FileUtils::OpenFolder(
+      "Export meshes...",
+      [&](const std::filesystem::path &path) { Export(generator, path); },
+      false);
+}
@@ -10,6 +10,7 @@
 #include "PanicleData.hpp"
 #include "SorghumData.hpp"
 #include "SorghumLayer.hpp"
+#include "SorghumMeshWriter.hpp"
 #include "StemData.hpp"
 #ifdef RAYTRACERFACILITY
 using namespace RayTracerFacility;
@@ -24,6 +25,48 @@ void SorghumData::OnDestroy() {
   m_seperated = true;
   m_includeStem = true;
   m_segmentedMask = false;
+  m_lazyGeneration = false;
+  m_geometryPending = false;
+  m_impostor = false;
+}
+
+bool SorghumData::IsGeometryPending() const { return m_geometryPending; }
+
+bool SorghumData::IsImpostor() const { return m_impostor; }
+
+void SorghumData::EnsureGeometry(bool fullGeometry) {
+  if (!m_geometryPending && !(fullGeometry && m_impostor))
+    return;
+  m_geometryPending = false;
+  auto sorghumLayer = Application::GetLayer<SorghumLayer>();
+  if (!fullGeometry && sorghumLayer &&
+      sorghumLayer->GetScene() == GetScene()) {
+    sorghumLayer->GenerateMeshForSorghum(GetOwner());
+    return;
+  }
+  FormPlant();
+  ApplyGeometry();
+}
+
+void SorghumData::ReleaseGeometry() {
+  auto scene = GetScene();
+  auto children = scene->GetChildren(GetOwner());
+  for (int i = 0; i < children.size(); i++) {
+    scene->DeleteEntity(children[i]);
+  }
+  m_meshGenerated = false;
+  m_impostor = false;
+  m_geometryPending = true;
+}
+
+bool SorghumData::IsLazyOrgan(const std::shared_ptr<Scene> &scene,
+                              const Entity &organ) {
+  const auto plant = scene->GetParent(organ);
+  return scene->IsEntityValid(plant) &&
+         scene->HasPrivateComponent<SorghumData>(plant) &&
+         scene->GetOrSetPrivateComponent<SorghumData>(plant)
+             .lock()
+             ->m_lazyGeneration;
 }
 
 void SorghumData::OnInspect() {
@@ -31,6 +74,7 @@ void SorghumData::OnInspect() {
   ImGui::Checkbox("Seperated", &m_seperated);
   ImGui::Checkbox("Include stem", &m_includeStem);
   ImGui::Checkbox("Mask", &m_segmentedMask);
+  ImGui::Checkbox("Save inputs only", &m_lazyGeneration);
   if (ImGui::Checkbox("Skeleton", &m_skeleton)) {
     FormPlant();
     ApplyGeometry();
@@ -76,6 +120,10 @@ void SorghumData::OnInspect() {
             ExportModel(path.string());
           },
           false);
+      FileUtils::SaveFile(
+          "Export PLY/GLB", "3D Model", {".ply", ".glb"},
+          [this](const std::filesystem::path &path) { ExportMesh(path); },
+          false);
 
       ImGui::TreePop();
     }
@@ -90,8 +138,26 @@ void SorghumData::OnInspect() {
   }
 }
 
+void SorghumData::ExportMesh(const std::filesystem::path &path) {
+  EnsureGeometry(true);
+  SorghumMeshFormat format;
+  if (!SorghumMeshWriter::GetFormat(path, format)) {
+    UNIENGINE_ERROR("Unsupported mesh format!");
+    return;
+  }
+  SorghumPlantMesh plantMesh;
+  plantMesh.Collect(GetScene(), GetOwner());
+  SorghumMeshWriter writer;
+  if (!writer.Open(path, format))
+    return;
+  writer.Write(plantMesh);
+  if (writer.Close())
+    UNIENGINE_LOG("Sorghum saved as " + path.string());
+}
+
 void SorghumData::ExportModel(const std::string &filename,
-                              const bool &includeFoliage) const {
+                              const bool &includeFoliage) {
+  EnsureGeometry(true);
   std::ofstream of;
   of.open(filename, std::ofstream::out | std::ofstream::trunc);
   if (of.is_open()) {
@@ -119,6 +185,8 @@ void SorghumData::Serialize(YAML::Emitter &out) {
   out << YAML::Key << "m_seperated" << YAML::Value << m_seperated;
   out << YAML::Key << "m_includeStem" << YAML::Value << m_includeStem;
   out << YAML::Key << "m_segmentedMask" << YAML::Value << m_segmentedMask;
+  out << YAML::Key << "m_bottomFace" << YAML::Value << m_bottomFace;
+  out << YAML::Key << "m_lazyGeneration" << YAML::Value << m_lazyGeneration;
   out << YAML::Key << "m_descriptor" << YAML::BeginMap;
   m_descriptor.Serialize(out);
   out << YAML::EndMap;
@@ -143,6 +211,11 @@ void SorghumData::Deserialize(const YAML::Node &in) {
     m_includeStem = in["m_includeStem"].as<bool>();
   if (in["m_segmentedMask"])
     m_segmentedMask = in["m_segmentedMask"].as<bool>();
+  if (in["m_bottomFace"])
+    m_bottomFace = in["m_bottomFace"].as<bool>();
+  if (in["m_lazyGeneration"])
+    m_lazyGeneration = in["m_lazyGeneration"].as<bool>();
+  m_geometryPending = m_lazyGeneration;
 
   if (in["m_recordedVersion"])
     m_recordedVersion = in["m_recordedVersion"].as<unsigned>();
@@ -155,6 +228,8 @@ void SorghumData::CollectAssetRef(std::vector<AssetRef> &list) {
 }
 
 void SorghumData::FormPlant() {
+  m_geometryPending = false;
+  m_impostor = false;
   SorghumStatePair statePair;
   auto sorghumLayer = Application::GetLayer<SorghumLayer>();
   auto scene = GetScene();
@@ -197,6 +272,41 @@ void SorghumData::FormPlant() {
       scene->GetOrSetPrivateComponent<PanicleData>(panicle).lock();
   panicleData->FormPanicle(statePair);
 }
+void SorghumData::CollectPoints(std::vector<glm::vec3> &points) const {
+  auto scene = GetScene();
+  scene->ForEachChild(GetOwner(), [&](Entity child) {
+    const std::vector<Vertex> *vertices = nullptr;
+    if (m_includeStem && scene->HasDataComponent<StemTag>(child)) {
+      vertices = &scene->GetOrSetPrivateComponent<StemData>(child).lock()->m_vertices;
+    } else if (scene->HasDataComponent<LeafTag>(child)) {
+      vertices = &scene->GetOrSetPrivateComponent<LeafData>(child).lock()->m_vertices;
+    } else if (scene->HasDataComponent<PanicleTag>(child)) {
+      vertices = &scene->GetOrSetPrivateComponent<PanicleData>(child).lock()->m_vertices;
+    }
+    if (!vertices)
+      return;
+    for (const auto &vertex : *vertices)
+      points.push_back(vertex.m_position);
+  });
+}
+void SorghumData::ApplyImpostor(const std::shared_ptr<Mesh> &impostor) {
+  m_geometryPending = false;
+  m_impostor = true;
+  auto scene = GetScene();
+  auto owner = GetOwner();
+  auto sorghumLayer = Application::GetLayer<SorghumLayer>();
+  auto children = scene->GetChildren(owner);
+  for (int i = 0; i < children.size(); i++) {
+    scene->DeleteEntity(children[i]);
+  }
+  auto impostorEntity = scene->CreateEntity("Impostor Geometry");
+  scene->SetParent(impostorEntity, owner);
+  auto meshRenderer =
+      scene->GetOrSetPrivateComponent<MeshRenderer>(impostorEntity).lock();
+  meshRenderer->m_mesh = impostor;
+  meshRenderer->m_material = sorghumLayer->m_leafMaterial;
+  m_meshGenerated = true;
+}
 void SorghumData::ApplyGeometry() {
   auto scene = GetScene();
   auto owner = GetOwner();
@@ -204,12 +314,15 @@ void SorghumData::ApplyGeometry() {
   bool seperated = m_seperated || m_segmentedMask;
   auto bottomFace = !m_skeleton && !m_segmentedMask && m_bottomFace;
 #ifdef RAYTRACERFACILITY
-  auto leafCBTFGroup = sorghumLayer->m_leafCBTFGroup.Get<CBTFGroup>();
+  //The BTF assets are only resolved when they are going to be rendered, a disabled BTF
+  //leaves the group and its data sets unloaded.
   bool btfAvailable = false;
   std::shared_ptr<DoubleCBTF> doubleCBTF;
-  if (leafCBTFGroup) {
-    doubleCBTF = leafCBTFGroup->GetRandom().Get<DoubleCBTF>();
-    btfAvailable = true;
+  if (sorghumLayer->m_enableCompressedBTF) {
+    if (auto leafCBTFGroup = sorghumLayer->m_leafCBTFGroup.Get<CBTFGroup>()) {
+      doubleCBTF = leafCBTFGroup->GetRandom().Get<DoubleCBTF>();
+      btfAvailable = doubleCBTF != nullptr;
+    }
   }
 #endif
 
@@ -558,6 +671,15 @@ void SorghumData::SetTime(float time) {
   m_currentTime = time;
   FormPlant();
 }
+void SorghumData::SetCurrentTime(float time) { m_currentTime = time; }
+float SorghumData::GetCurrentTime() const { return m_currentTime; }
+void SorghumData::RecordDescriptorVersion() {
+  if (auto proceduralSorghum = m_descriptor.Get<ProceduralSorghum>())
+    m_recordedVersion = proceduralSorghum->GetVersion();
+  else if (auto sorghumStateGenerator =
+               m_descriptor.Get<SorghumStateGenerator>())
+    m_recordedVersion = sorghumStateGenerator->GetVersion();
+}
 void SorghumData::SetEnableSegmentedMask(bool value) {
   if (!m_seperated) {
     UNIENGINE_ERROR("Leaf not seperated!");
@@ -3,6 +3,11 @@
 //
 
 #include "SorghumField.hpp"
+#include "FieldGround.hpp"
+#include "LeafData.hpp"
+#include "MappedFile.hpp"
+#include "PanicleData.hpp"
+#include "StemData.hpp"
 #include "SorghumData.hpp"
 #include "SorghumLayer.hpp"
 #include "SorghumStateGenerator.hpp"
@@ -32,14 +37,32 @@ void RectangularSorghumFieldPattern::GenerateField(
 void SorghumField::OnInspect() {
   ImGui::Checkbox("Seperated", &m_seperated);
   ImGui::Checkbox("Include stem", &m_includeStem);
+  ImGui::Checkbox("Save inputs only", &m_lazyGeneration);
 
   ImGui::DragInt("Size limit", &m_sizeLimit, 1, 0, 10000);
   ImGui::DragFloat("Sorghum size", &m_sorghumSize, 0.01f, 0, 10);
   if (ImGui::Button("Refresh matrices")) {
     GenerateMatrices();
   }
+  static Entity lastField;
   if (ImGui::Button("Instantiate")) {
-    InstantiateField();
+    lastField = InstantiateField();
+  }
+  auto scene = Application::GetActiveScene();
+  if (scene->IsEntityValid(lastField)) {
+    FileUtils::SaveFile("Save snapshot", "Field snapshot", {".sfsnap"},
+                        [&](const std::filesystem::path &path) {
+                          SaveSnapshot(scene, lastField, path);
+                        });
+  }
+  FileUtils::OpenFile("Restore snapshot", "Field snapshot", {".sfsnap"},
+                      [&](const std::filesystem::path &path) {
+                        lastField = RestoreSnapshot(path);
+                      });
+  static AssetRef ground;
+  Editor::DragAndDropButton<FieldGround>(ground, "Ground");
+  if (ground.Get<FieldGround>() && ImGui::Button("Snap to ground")) {
+    SnapToGround(*ground.Get<FieldGround>());
   }
 
   ImGui::Text("Matrices count: %d", (int)m_newSorghums.size());
@@ -49,16 +72,32 @@ void SorghumField::Serialize(YAML::Emitter &out) {
   out << YAML::Key << "m_sorghumSize" << YAML::Value << m_sorghumSize;
   out << YAML::Key << "m_seperated" << YAML::Value << m_seperated;
   out << YAML::Key << "m_includeStem" << YAML::Value << m_includeStem;
+  out << YAML::Key << "m_lazyGeneration" << YAML::Value << m_lazyGeneration;
 
 
-  out << YAML::Key << "m_newSorghums" << YAML::Value << YAML::BeginSeq;
-  for (auto &i : m_newSorghums) {
+  std::vector<SorghumFieldPlant> plants(m_newSorghums.size());
+  for (int i = 0; i < m_newSorghums.size(); i++) {
+    const auto &newSorghum = m_newSorghums[i];
+    auto &plant = plants[i];
+    plant.m_descriptorIndex = newSorghum.m_descriptorIndex;
+    plant.m_seed = newSorghum.m_seed;
+    const auto &matrix = newSorghum.m_transform;
+    plant.m_position = matrix[3];
+    plant.m_scale = glm::vec3(glm::length(glm::vec3(matrix[0])),
+                              glm::length(glm::vec3(matrix[1])),
+                              glm::length(glm::vec3(matrix[2])));
+    plant.m_rotation = glm::quat_cast(glm::mat3(glm::vec3(matrix[0]) / plant.m_scale.x,
+                                                glm::vec3(matrix[1]) / plant.m_scale.y,
+                                                glm::vec3(matrix[2]) / plant.m_scale.z));
+  }
+  out << YAML::Key << "m_descriptors" << YAML::Value << YAML::BeginSeq;
+  for (auto &i : m_descriptors) {
     out << YAML::BeginMap;
-    i.first.Save("SPD", out);
-    out << YAML::Key << "Transform" << YAML::Value << i.second;
+    i.Save("Descriptor", out);
     out << YAML::EndMap;
   }
   out << YAML::EndSeq;
+  SaveListAsBinary<SorghumFieldPlant>("m_plants", plants, out);
 }
 void SorghumField::Deserialize(const YAML::Node &in) {
   if (in["m_sizeLimit"])
@@ -70,20 +109,56 @@ void SorghumField::Deserialize(const YAML::Node &in) {
     m_seperated = in["m_seperated"].as<bool>();
   if (in["m_includeStem"])
     m_includeStem = in["m_includeStem"].as<bool>();
+  if (in["m_lazyGeneration"])
+    m_lazyGeneration = in["m_lazyGeneration"].as<bool>();
 
-  m_newSorghums.clear();
-  if (in["m_newSorghums"]) {
+  ClearPlants();
+  if (in["m_descriptors"]) {
+    for (const auto &i : in["m_descriptors"]) {
+      m_descriptors.emplace_back();
+      m_descriptors.back().Load("Descriptor", i);
+    }
+    std::vector<SorghumFieldPlant> plants;
+    LoadListFromBinary<SorghumFieldPlant>("m_plants", plants, in);
+    m_newSorghums.resize(plants.size());
+    for (int i = 0; i < plants.size(); i++) {
+      const auto &plant = plants[i];
+      auto &newSorghum = m_newSorghums[i];
+      newSorghum.m_descriptorIndex = plant.m_descriptorIndex;
+      newSorghum.m_seed = plant.m_seed;
+      newSorghum.m_transform = glm::translate(plant.m_position) *
+                               glm::mat4_cast(plant.m_rotation) *
+                               glm::scale(plant.m_scale);
+    }
+  } else if (in["m_newSorghums"]) {
     for (const auto &i : in["m_newSorghums"]) {
       AssetRef spd;
       spd.Load("SPD", i);
-      m_newSorghums.emplace_back(spd, i["Transform"].as<glm::mat4>());
+      NewSorghum newSorghum;
+      newSorghum.m_descriptorIndex = AddDescriptor(spd);
+      newSorghum.m_seed = m_newSorghums.size();
+      newSorghum.m_transform = i["Transform"].as<glm::mat4>();
+      m_newSorghums.push_back(newSorghum);
     }
   }
 }
 void SorghumField::CollectAssetRef(std::vector<AssetRef> &list) {
-  for (auto &i : m_newSorghums) {
-    list.push_back(i.first);
+  for (auto &i : m_descriptors) {
+    list.push_back(i);
+  }
+}
+int SorghumField::AddDescriptor(const AssetRef &descriptor) {
+  const auto asset = descriptor.Get<IAsset>();
+  for (int i = 0; i < m_descriptors.size(); i++) {
+    if (m_descriptors[i].Get<IAsset>() == asset)
+      return i;
   }
+  m_descriptors.push_back(descriptor);
+  return m_descriptors.size() - 1;
+}
+void SorghumField::ClearPlants() {
+  m_descriptors.clear();
+  m_newSorghums.clear();
 }
 Entity SorghumField::InstantiateField() {
   if (m_newSorghums.empty())
@@ -97,31 +172,48 @@ Entity SorghumField::InstantiateField() {
   auto sorghumLayer = Application::GetLayer<SorghumLayer>();
   auto scene = sorghumLayer->GetScene();
   if (sorghumLayer) {
-    auto fieldAsset = std::dynamic_pointer_cast<SorghumField>(m_self.lock());
     auto field = scene->CreateEntity("Field");
-    // Create sorghums here.
-    int size = 0;
-    for (auto &newSorghum : fieldAsset->m_newSorghums) {
-      Entity sorghumEntity = sorghumLayer->CreateSorghum();
+    // Descriptors are resolved once for the whole field.
+    std::vector<int> modes(m_descriptors.size());
+    for (int i = 0; i < m_descriptors.size(); i++) {
+      modes[i] = m_descriptors[i].Get<ProceduralSorghum>()
+                     ? (int)SorghumMode::ProceduralSorghum
+                     : (int)SorghumMode::SorghumStateGenerator;
+    }
+    const int size = glm::min((int)m_newSorghums.size(), m_sizeLimit);
+    std::vector<Entity> sorghumEntities(size);
+    for (int i = 0; i < size; i++) {
+      const auto &newSorghum = m_newSorghums[i];
+      Entity sorghumEntity = sorghumEntities[i] = sorghumLayer->CreateSorghum();
       auto sorghumTransform = scene->GetDataComponent<Transform>(sorghumEntity);
-      sorghumTransform.m_value = newSorghum.second;
+      sorghumTransform.m_value = newSorghum.m_transform;
       sorghumTransform.SetScale(glm::vec3(m_sorghumSize));
       scene->SetDataComponent(sorghumEntity, sorghumTransform);
       auto sorghumData =
           scene->GetOrSetPrivateComponent<SorghumData>(sorghumEntity).lock();
-      sorghumData->m_mode = (int)SorghumMode::SorghumStateGenerator;
-      sorghumData->m_descriptor = newSorghum.first;
-      sorghumData->m_seed = size;
+      if (newSorghum.m_descriptorIndex >= 0 &&
+          newSorghum.m_descriptorIndex < m_descriptors.size()) {
+        sorghumData->m_mode = modes[newSorghum.m_descriptorIndex];
+        sorghumData->m_descriptor = m_descriptors[newSorghum.m_descriptorIndex];
+      }
+      sorghumData->m_seed = newSorghum.m_seed;
       sorghumData->m_seperated = m_seperated;
       sorghumData->m_includeStem = m_includeStem;
-      sorghumData->SetTime(1.0f);
+      sorghumData->m_lazyGeneration = m_lazyGeneration;
+      sorghumData->SetCurrentTime(1.0f);
       scene->SetParent(sorghumEntity, field);
-      size++;
-      if (size >= m_sizeLimit)
-        break;
     }
-
-    Application::GetLayer<SorghumLayer>()->GenerateMeshForAllSorghums();
+    // Generate genotype by genotype so consecutive plants share a descriptor.
+    std::vector<int> order(size);
+    for (int i = 0; i < size; i++)
+      order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+      return m_newSorghums[a].m_descriptorIndex <
+             m_newSorghums[b].m_descriptorIndex;
+    });
+    for (const auto i : order) {
+      sorghumLayer->GenerateMeshForSorghum(sorghumEntities[i]);
+    }
 
     Application::GetLayer<TransformLayer>()
         ->CalculateTransformGraphForDescendents(scene,
@@ -132,11 +224,360 @@ Entity SorghumField::InstantiateField() {
     return {};
   }
 }
+void SorghumField::SnapToGround(const FieldGround &ground, float groundHeight) {
+  if (!ground.HasHeightCache()) {
+    UNIENGINE_ERROR("Ground not generated!");
+    return;
+  }
+  std::vector<glm::vec2> positions(m_newSorghums.size());
+  for (int i = 0; i < m_newSorghums.size(); i++) {
+    const auto &translation = m_newSorghums[i].m_transform[3];
+    positions[i] = glm::vec2(translation.x, translation.z);
+  }
+  std::vector<float> heights;
+  ground.SampleHeights(positions, heights);
+  for (int i = 0; i < m_newSorghums.size(); i++) {
+    m_newSorghums[i].m_transform[3].y = heights[i] + groundHeight;
+  }
+}
+
+#pragma region Snapshot
+namespace SorghumFieldSnapshot {
+enum class OrganType : int { Stem, Leaf, Panicle };
+struct Header {
+  char m_magic[8] = {'S', 'F', 'S', 'N', 'A', 'P', '\0', '\0'};
+  unsigned m_version = 2;
+  unsigned m_plantCount = 0;
+  unsigned long long m_organCount = 0;
+  unsigned long long m_plantOffset = 0;
+  unsigned long long m_organOffset = 0;
+  unsigned long long m_size = 0;
+};
+struct PlantRecord {
+  glm::mat4 m_transform;
+  unsigned m_firstOrgan = 0;
+  unsigned m_organCount = 0;
+  int m_seed = 0;
+  int m_flags = 0;
+  //Handle of the descriptor asset, 0 without one. It is resolved through the project on restore.
+  unsigned long long m_descriptor = 0;
+  int m_mode = 0;
+  float m_time = 1.0f;
+};
+struct ArrayRecord {
+  unsigned long long m_offset = 0;
+  unsigned long long m_count = 0;
+};
+struct OrganRecord {
+  int m_type = 0;
+  int m_leafIndex = 0;
+  glm::vec4 m_vertexColor;
+  glm::vec3 m_leafSheath;
+  float m_branchingAngle = 0;
+  glm::vec3 m_leafTip;
+  float m_rollAngle = 0;
+  ArrayRecord m_vertices;
+  ArrayRecord m_triangles;
+  ArrayRecord m_bottomFaceVertices;
+  ArrayRecord m_bottomFaceTriangles;
+};
+constexpr int SeperatedFlag = 1;
+constexpr int IncludeStemFlag = 2;
+constexpr int BottomFaceFlag = 4;
+inline unsigned long long Align(unsigned long long offset) {
+  return (offset + 15) / 16 * 16;
+}
+template <typename T>
+ArrayRecord Reserve(const std::vector<T> &list, unsigned long long &offset) {
+  ArrayRecord record;
+  record.m_offset = offset = Align(offset);
+  record.m_count = list.size();
+  offset += list.size() * sizeof(T);
+  return record;
+}
+template <typename T>
+void Write(std::ofstream &of, const ArrayRecord &record,
+           const std::vector<T> &list) {
+  if (record.m_count == 0)
+    return;
+  of.seekp(record.m_offset);
+  of.write((const char *)list.data(), list.size() * sizeof(T));
+}
+//Whether count elements of T starting at offset lie within size bytes, without overflowing.
+template <typename T>
+bool InRange(unsigned long long offset, unsigned long long count,
+             unsigned long long size) {
+  return offset <= size && count <= (size - offset) / sizeof(T);
+}
+template <typename T>
+bool InRange(const ArrayRecord &record, unsigned long long size) {
+  return InRange<T>(record.m_offset, record.m_count, size);
+}
+//Whether every triangle of an in range record indexes one of vertexCount vertices.
+static bool ValidTriangles(const MappedFile &file, const ArrayRecord &triangles,
+                           unsigned long long vertexCount) {
+  const auto *begin = (const glm::uvec3 *)(file.GetData() + triangles.m_offset);
+  for (unsigned long long i = 0; i < triangles.m_count; i++) {
+    if (begin[i].x >= vertexCount || begin[i].y >= vertexCount ||
+        begin[i].z >= vertexCount)
+      return false;
+  }
+  return true;
+}
+template <typename T>
+bool Read(const MappedFile &file, const ArrayRecord &record,
+          std::vector<T> &list) {
+  if (!InRange<T>(record, file.GetSize()))
+    return false;
+  const auto *begin = (const T *)(file.GetData() + record.m_offset);
+  list.assign(begin, begin + record.m_count);
+  return true;
+}
+} // namespace SorghumFieldSnapshot
+
+bool SorghumField::SaveSnapshot(const std::shared_ptr<Scene> &scene,
+                                const Entity &field,
+                                const std::filesystem::path &path) {
+  using namespace SorghumFieldSnapshot;
+  std::vector<PlantRecord> plants;
+  std::vector<OrganRecord> organs;
+  std::vector<std::shared_ptr<IPrivateComponent>> organData;
+  for (const auto &plant : scene->GetChildren(field)) {
+    if (!scene->HasPrivateComponent<SorghumData>(plant))
+      continue;
+    auto sorghumData = scene->GetOrSetPrivateComponent<SorghumData>(plant).lock();
+    sorghumData->EnsureGeometry(true);
+    PlantRecord plantRecord;
+    plantRecord.m_transform = scene->GetDataComponent<Transform>(plant).m_value;
+    plantRecord.m_firstOrgan = organs.size();
+    plantRecord.m_seed = sorghumData->m_seed;
+    if (auto descriptor = sorghumData->m_descriptor.Get<IAsset>())
+      plantRecord.m_descriptor = descriptor->GetHandle().GetValue();
+    plantRecord.m_mode = sorghumData->m_mode;
+    plantRecord.m_time = sorghumData->GetCurrentTime();
+    plantRecord.m_flags = (sorghumData->m_seperated ? SeperatedFlag : 0) |
+                          (sorghumData->m_includeStem ? IncludeStemFlag : 0) |
+                          (sorghumData->m_bottomFace ? BottomFaceFlag : 0);
+    scene->ForEachChild(plant, [&](Entity child) {
+      OrganRecord organRecord;
+      if (scene->HasPrivateComponent<StemData>(child)) {
+        auto stemData = scene->GetOrSetPrivateComponent<StemData>(child).lock();
+        organRecord.m_type = (int)OrganType::Stem;
+        organRecord.m_vertexColor = stemData->m_vertexColor;
+        organData.push_back(stemData);
+      } else if (scene->HasPrivateComponent<LeafData>(child)) {
+        auto leafData = scene->GetOrSetPrivateComponent<LeafData>(child).lock();
+        organRecord.m_type = (int)OrganType::Leaf;
+        organRecord.m_leafIndex = leafData->m_index;
+        organRecord.m_vertexColor = leafData->m_vertexColor;
+        organRecord.m_leafSheath = leafData->m_leafSheath;
+        organRecord.m_leafTip = leafData->m_leafTip;
+        organRecord.m_branchingAngle = leafData->m_branchingAngle;
+        organRecord.m_rollAngle = leafData->m_rollAngle;
+        organData.push_back(leafData);
+      } else if (scene->HasPrivateComponent<PanicleData>(child)) {
+        organRecord.m_type = (int)OrganType::Panicle;
+        organData.push_back(
+            scene->GetOrSetPrivateComponent<PanicleData>(child).lock());
+      } else {
+        return;
+      }
+      organs.push_back(organRecord);
+    });
+    plantRecord.m_organCount = organs.size() - plantRecord.m_firstOrgan;
+    plants.push_back(plantRecord);
+  }
+
+  Header header;
+  header.m_plantCount = plants.size();
+  header.m_organCount = organs.size();
+  unsigned long long offset = sizeof(Header);
+  header.m_plantOffset = offset = Align(offset);
+  offset += plants.size() * sizeof(PlantRecord);
+  header.m_organOffset = offset = Align(offset);
+  offset += organs.size() * sizeof(OrganRecord);
+  for (int i = 0; i < organs.size(); i++) {
+    auto &organ = organs[i];
+    switch ((OrganType)organ.m_type) {
+    case OrganType::Stem: {
+      auto stemData = std::static_pointer_cast<StemData>(organData[i]);
+      organ.m_vertices = Reserve(stemData->m_vertices, offset);
+      organ.m_triangles = Reserve(stemData->m_triangles, offset);
+    } break;
+    case OrganType::Leaf: {
+      auto leafData = std::static_pointer_cast<LeafData>(organData[i]);
+      organ.m_vertices = Reserve(leafData->m_vertices, offset);
+      organ.m_triangles = Reserve(leafData->m_triangles, offset);
+      organ.m_bottomFaceVertices = Reserve(leafData->m_bottomFaceVertices, offset);
+      organ.m_bottomFaceTriangles = Reserve(leafData->m_bottomFaceTriangles, offset);
+    } break;
+    case OrganType::Panicle: {
+      auto panicleData = std::static_pointer_cast<PanicleData>(organData[i]);
+      organ.m_vertices = Reserve(panicleData->m_vertices, offset);
+      organ.m_triangles = Reserve(panicleData->m_triangles, offset);
+    } break;
+    }
+  }
+  header.m_size = offset;
+
+  std::ofstream of(path, std::ofstream::out | std::ofstream::binary |
+                             std::ofstream::trunc);
+  if (!of.is_open()) {
+    UNIENGINE_ERROR("Can't open file!");
+    return false;
+  }
+  of.write((const char *)&header, sizeof(Header));
+  of.seekp(header.m_plantOffset);
+  of.write((const char *)plants.data(), plants.size() * sizeof(PlantRecord));
+  of.seekp(header.m_organOffset);
+  of.write((const char *)organs.data(), organs.size() * sizeof(OrganRecord));
+  for (int i = 0; i < organs.size(); i++) {
+    const auto &organ = organs[i];
+    switch ((OrganType)organ.m_type) {
+    case OrganType::Stem: {
+      auto stemData = std::static_pointer_cast<StemData>(organData[i]);
+      Write(of, organ.m_vertices, stemData->m_vertices);
+      Write(of, organ.m_triangles, stemData->m_triangles);
+    } break;
+    case OrganType::Leaf: {
+      auto leafData = std::static_pointer_cast<LeafData>(organData[i]);
+      Write(of, organ.m_vertices, leafData->m_vertices);
+      Write(of, organ.m_triangles, leafData->m_triangles);
+      Write(of, organ.m_bottomFaceVertices, leafData->m_bottomFaceVertices);
+      Write(of, organ.m_bottomFaceTriangles, leafData->m_bottomFaceTriangles);
+    } break;
+    case OrganType::Panicle: {
+      auto panicleData = std::static_pointer_cast<PanicleData>(organData[i]);
+      Write(of, organ.m_vertices, panicleData->m_vertices);
+      Write(of, organ.m_triangles, panicleData->m_triangles);
+    } break;
+    }
+  }
+  // Pad to the recorded size so trailing empty arrays stay in range.
+  of.seekp(0, std::ofstream::end);
+  const auto end = (unsigned long long)of.tellp();
+  if (end < header.m_size) {
+    const std::vector<char> padding(header.m_size - end, 0);
+    of.write(padding.data(), padding.size());
+  }
+  of.close();
+  UNIENGINE_LOG("Field snapshot saved as " + path.string());
+  return true;
+}
+
+Entity SorghumField::RestoreSnapshot(const std::filesystem::path &path) {
+  using namespace SorghumFieldSnapshot;
+  MappedFile file;
+  if (!file.Open(path) || file.GetSize() < sizeof(Header)) {
+    UNIENGINE_ERROR("Can't open file!");
+    return {};
+  }
+  const auto &header = *(const Header *)file.GetData();
+  if (std::memcmp(header.m_magic, Header().m_magic, sizeof(header.m_magic)) != 0 ||
+      header.m_version != Header().m_version || header.m_size > file.GetSize()) {
+    UNIENGINE_ERROR("Invalid field snapshot!");
+    return {};
+  }
+  // Every table and array has to lie inside the file before anything is created.
+  const auto size = header.m_size;
+  if (!InRange<PlantRecord>(header.m_plantOffset, header.m_plantCount, size) ||
+      !InRange<OrganRecord>(header.m_organOffset, header.m_organCount, size)) {
+    UNIENGINE_ERROR("Corrupted field snapshot!");
+    return {};
+  }
+  {
+    const auto *organs =
+        (const OrganRecord *)(file.GetData() + header.m_organOffset);
+    for (unsigned long long i = 0; i < header.m_organCount; i++) {
+      const auto &organ = organs[i];
+      if (!InRange<Vertex>(organ.m_vertices, size) ||
+          !InRange<glm::uvec3>(organ.m_triangles, size) ||
+          !InRange<Vertex>(organ.m_bottomFaceVertices, size) ||
+          !InRange<glm::uvec3>(organ.m_bottomFaceTriangles, size) ||
+          !ValidTriangles(file, organ.m_triangles, organ.m_vertices.m_count) ||
+          !ValidTriangles(file, organ.m_bottomFaceTriangles,
+                          organ.m_bottomFaceVertices.m_count)) {
+        UNIENGINE_ERROR("Corrupted field snapshot!");
+        return {};
+      }
+    }
+  }
+  auto sorghumLayer = Application::GetLayer<SorghumLayer>();
+  if (!sorghumLayer) {
+    UNIENGINE_ERROR("No sorghum layer!");
+    return {};
+  }
+  auto scene = sorghumLayer->GetScene();
+  const auto *plants = (const PlantRecord *)(file.GetData() + header.m_plantOffset);
+  const auto *organs = (const OrganRecord *)(file.GetData() + header.m_organOffset);
+  auto field = scene->CreateEntity("Field");
+  for (unsigned i = 0; i < header.m_plantCount; i++) {
+    const auto &plant = plants[i];
+    Entity sorghumEntity = sorghumLayer->CreateSorghum();
+    auto sorghumTransform = scene->GetDataComponent<Transform>(sorghumEntity);
+    sorghumTransform.m_value = plant.m_transform;
+    scene->SetDataComponent(sorghumEntity, sorghumTransform);
+    auto sorghumData =
+        scene->GetOrSetPrivateComponent<SorghumData>(sorghumEntity).lock();
+    sorghumData->m_seed = plant.m_seed;
+    sorghumData->m_mode = plant.m_mode;
+    sorghumData->SetCurrentTime(plant.m_time);
+    if (plant.m_descriptor != 0) {
+      sorghumData->m_descriptor =
+          ProjectManager::GetAsset(Handle(plant.m_descriptor));
+      // The stored geometry is current, auto refresh must not rebuild it.
+      sorghumData->RecordDescriptorVersion();
+    }
+    sorghumData->m_seperated = plant.m_flags & SeperatedFlag;
+    sorghumData->m_includeStem = plant.m_flags & IncludeStemFlag;
+    sorghumData->m_bottomFace = plant.m_flags & BottomFaceFlag;
+    for (unsigned j = plant.m_firstOrgan;
+         j < plant.m_firstOrgan + plant.m_organCount && j < header.m_organCount; j++) {
+      const auto &organ = organs[j];
+      switch ((OrganType)organ.m_type) {
+      case OrganType::Stem: {
+        auto stem = sorghumLayer->CreateSorghumStem(sorghumEntity);
+        auto stemData = scene->GetOrSetPrivateComponent<StemData>(stem).lock();
+        stemData->m_vertexColor = organ.m_vertexColor;
+        Read(file, organ.m_vertices, stemData->m_vertices);
+        Read(file, organ.m_triangles, stemData->m_triangles);
+      } break;
+      case OrganType::Leaf: {
+        auto leaf = sorghumLayer->CreateSorghumLeaf(sorghumEntity, organ.m_leafIndex);
+        auto leafData = scene->GetOrSetPrivateComponent<LeafData>(leaf).lock();
+        leafData->m_vertexColor = organ.m_vertexColor;
+        leafData->m_leafSheath = organ.m_leafSheath;
+        leafData->m_leafTip = organ.m_leafTip;
+        leafData->m_branchingAngle = organ.m_branchingAngle;
+        leafData->m_rollAngle = organ.m_rollAngle;
+        Read(file, organ.m_vertices, leafData->m_vertices);
+        Read(file, organ.m_triangles, leafData->m_triangles);
+        Read(file, organ.m_bottomFaceVertices, leafData->m_bottomFaceVertices);
+        Read(file, organ.m_bottomFaceTriangles, leafData->m_bottomFaceTriangles);
+      } break;
+      case OrganType::Panicle: {
+        auto panicle = sorghumLayer->CreateSorghumPanicle(sorghumEntity);
+        auto panicleData =
+            scene->GetOrSetPrivateComponent<PanicleData>(panicle).lock();
+        Read(file, organ.m_vertices, panicleData->m_vertices);
+        Read(file, organ.m_triangles, panicleData->m_triangles);
+      } break;
+      }
+    }
+    sorghumData->ApplyGeometry();
+    scene->SetParent(sorghumEntity, field);
+  }
+  Application::GetLayer<TransformLayer>()->CalculateTransformGraphForDescendents(
+      scene, field);
+  return field;
+}
+#pragma endregion
 
 void RectangularSorghumField::GenerateMatrices() {
   if (!m_sorghumStateGenerator.Get<SorghumStateGenerator>())
     return;
-  m_newSorghums.clear();
+  ClearPlants();
+  const int descriptorIndex = AddDescriptor(m_sorghumStateGenerator);
   for (int xi = 0; xi < m_size.x; xi++) {
     for (int yi = 0; yi < m_size.y; yi++) {
       auto position =
@@ -145,10 +586,10 @@ void RectangularSorghumField::GenerateMatrices() {
           glm::vec3(xi * m_distance.x, 0.0f, yi * m_distance.y);
       auto rotation = glm::quat(glm::radians(
           glm::vec3(glm::gaussRand(glm::vec3(0.0f), m_rotationVariance))));
-      m_newSorghums.emplace_back(m_sorghumStateGenerator,
+      m_newSorghums.push_back({descriptorIndex, (int)m_newSorghums.size(),
                                  glm::translate(position) *
                                      glm::mat4_cast(rotation) *
-                                     glm::scale(glm::vec3(1.0f)));
+                                     glm::scale(glm::vec3(1.0f))});
     }
   }
 }
@@ -189,7 +630,8 @@ void RectangularSorghumField::CollectAssetRef(std::vector<AssetRef> &list) {
 void PositionsField::GenerateMatrices() {
   if (!m_sorghumStateGenerator.Get<SorghumStateGenerator>())
     return;
-  m_newSorghums.clear();
+  ClearPlants();
+  const int descriptorIndex = AddDescriptor(m_sorghumStateGenerator);
   for (auto &position : m_positions) {
     if (position.x < m_sampleX.x || position.y < m_sampleY.x ||
         position.x > m_sampleX.y || position.y > m_sampleY.y)
@@ -199,9 +641,9 @@ void PositionsField::GenerateMatrices() {
         m_factor;
     auto rotation = glm::quat(glm::radians(
         glm::vec3(glm::gaussRand(glm::vec3(0.0f), m_rotationVariance))));
-    m_newSorghums.emplace_back(m_sorghumStateGenerator,
+    m_newSorghums.push_back({descriptorIndex, (int)m_newSorghums.size(),
                                glm::translate(pos) * glm::mat4_cast(rotation) *
-                                   glm::scale(glm::vec3(1.0f)));
+                                   glm::scale(glm::vec3(1.0f))});
   }
 }
 void PositionsField::OnInspect() {
@@ -209,6 +651,8 @@ void PositionsField::OnInspect() {
   Editor::DragAndDropButton<SorghumStateGenerator>(m_sorghumStateGenerator,
                                                    "SorghumStateGenerator");
   ImGui::Text("Available count: %d", m_positions.size());
+  BinarySidecar::OnInspect(std::dynamic_pointer_cast<IAsset>(m_self.lock()),
+                           "PositionsField", ".possorghumfield");
   ImGui::DragFloat("Distance factor", &m_factor, 0.01f, 0.0f, 20.0f);
   ImGui::DragFloat3("Rotation variance", &m_rotationVariance.x, 0.01f, 0.0f,
                     180.0f);
@@ -325,8 +769,9 @@ PositionsField::InstantiateAroundIndex(unsigned i, float radius, glm::dvec2& off
       sorghumData->m_mode = 1;
       sorghumData->m_seperated = m_seperated;
       sorghumData->m_includeStem = m_includeStem;
+      sorghumData->m_lazyGeneration = m_lazyGeneration;
       sorghumData->m_seed = glm::linearRand(0, INT_MAX);
-      sorghumData->SetTime(1.0f);
+      sorghumData->SetCurrentTime(1.0f);
       scene->SetParent(sorghumEntity, field);
       size++;
       if (size >= m_sizeLimit)
@@ -344,3 +789,229 @@ PositionsField::InstantiateAroundIndex(unsigned i, float radius, glm::dvec2& off
     return {};
   }
 }
+
+void RowSorghumField::GenerateMatrices() {
+  if (!m_sorghumStateGenerator.Get<SorghumStateGenerator>())
+    return;
+  ClearPlants();
+  const int descriptorIndex = AddDescriptor(m_sorghumStateGenerator);
+  const float inRowSpacing = glm::max(m_inRowSpacing, 0.001f);
+  const int plantsPerRow = (int)(m_rowLength / inRowSpacing) + 1;
+  const auto orientation =
+      glm::angleAxis(glm::radians(m_rowOrientation), glm::vec3(0, 1, 0));
+  const auto center = glm::vec3(m_rowSpacing * (m_rowAmount - 1), 0.0f,
+                                inRowSpacing * (plantsPerRow - 1)) /
+                      2.0f;
+  m_newSorghums.reserve(m_rowAmount * plantsPerRow);
+  for (int row = 0; row < m_rowAmount; row++) {
+    for (int i = 0; i < plantsPerRow; i++) {
+      if (glm::linearRand(0.0f, 1.0f) > m_emergenceProbability)
+        continue;
+      auto position =
+          glm::vec3(row * m_rowSpacing, 0.0f,
+                    i * inRowSpacing +
+                        glm::gaussRand(0.0f, m_inRowSpacingVariance)) -
+          center;
+      auto rotation = glm::quat(glm::radians(
+          glm::vec3(glm::gaussRand(glm::vec3(0.0f), m_rotationVariance))));
+      m_newSorghums.push_back({descriptorIndex, (int)m_newSorghums.size(),
+                                 glm::translate(orientation * position) *
+                                     glm::mat4_cast(rotation) *
+                                     glm::scale(glm::vec3(1.0f))});
+    }
+  }
+}
+void RowSorghumField::OnInspect() {
+  SorghumField::OnInspect();
+  Editor::DragAndDropButton<SorghumStateGenerator>(m_sorghumStateGenerator,
+                                                   "SorghumStateGenerator");
+  ImGui::DragInt("Row amount", &m_rowAmount, 1, 1, 10000);
+  ImGui::DragFloat("Row length", &m_rowLength, 0.1f, 0.0f, 10000.0f);
+  ImGui::DragFloat("Row spacing", &m_rowSpacing, 0.01f, 0.0f, 100.0f);
+  ImGui::DragFloat("In-row spacing", &m_inRowSpacing, 0.01f, 0.001f, 100.0f);
+  ImGui::DragFloat("In-row spacing variance", &m_inRowSpacingVariance, 0.001f,
+                   0.0f, 10.0f);
+  ImGui::SliderFloat("Emergence probability", &m_emergenceProbability, 0.0f,
+                     1.0f);
+  ImGui::DragFloat("Row orientation", &m_rowOrientation, 0.1f, -180.0f,
+                   180.0f);
+  ImGui::DragFloat3("Rotation variance", &m_rotationVariance.x, 0.01f, 0.0f,
+                    180.0f);
+}
+void RowSorghumField::Serialize(YAML::Emitter &out) {
+  m_sorghumStateGenerator.Save("m_sorghumStateGenerator", out);
+  out << YAML::Key << "m_rowAmount" << YAML::Value << m_rowAmount;
+  out << YAML::Key << "m_rowLength" << YAML::Value << m_rowLength;
+  out << YAML::Key << "m_rowSpacing" << YAML::Value << m_rowSpacing;
+  out << YAML::Key << "m_inRowSpacing" << YAML::Value << m_inRowSpacing;
+  out << YAML::Key << "m_inRowSpacingVariance" << YAML::Value
+      << m_inRowSpacingVariance;
+  out << YAML::Key << "m_emergenceProbability" << YAML::Value
+      << m_emergenceProbability;
+  out << YAML::Key << "m_rowOrientation" << YAML::Value << m_rowOrientation;
+  out << YAML::Key << "m_rotationVariance" << YAML::Value << m_rotationVariance;
+  SorghumField::Serialize(out);
+}
+void RowSorghumField::Deserialize(const YAML::Node &in) {
+  m_sorghumStateGenerator.Load("m_sorghumStateGenerator", in);
+  if (in["m_rowAmount"])
+    m_rowAmount = in["m_rowAmount"].as<int>();
+  if (in["m_rowLength"])
+    m_rowLength = in["m_rowLength"].as<float>();
+  if (in["m_rowSpacing"])
+    m_rowSpacing = in["m_rowSpacing"].as<float>();
+  if (in["m_inRowSpacing"])
+    m_inRowSpacing = in["m_inRowSpacing"].as<float>();
+  if (in["m_inRowSpacingVariance"])
+    m_inRowSpacingVariance = in["m_inRowSpacingVariance"].as<float>();
+  if (in["m_emergenceProbability"])
+    m_emergenceProbability = in["m_emergenceProbability"].as<float>();
+  if (in["m_rowOrientation"])
+    m_rowOrientation = in["m_rowOrientation"].as<float>();
+  if (in["m_rotationVariance"])
+    m_rotationVariance = in["m_rotationVariance"].as<glm::vec3>();
+  SorghumField::Deserialize(in);
+}
+void RowSorghumField::CollectAssetRef(std::vector<AssetRef> &list) {
+  SorghumField::CollectAssetRef(list);
+  list.push_back(m_sorghumStateGenerator);
+}
+
+void PoissonDiskSorghumField::GeneratePoints() {
+  m_points.clear();
+  const float minDistance = glm::max(m_minDistance, 0.001f);
+  const float cellSize = minDistance / glm::sqrt(2.0f);
+  const auto gridSize =
+      glm::max(glm::ivec2(glm::ceil(m_size / cellSize)), glm::ivec2(1));
+  // Each grid cell holds at most one sample, -1 for empty.
+  std::vector<int> grid(gridSize.x * gridSize.y, -1);
+  std::vector<int> active;
+  std::mt19937 generator(m_seed);
+  std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+  auto cellOf = [&](const glm::vec2 &point) {
+    return glm::clamp(glm::ivec2(point / cellSize), glm::ivec2(0),
+                      gridSize - 1);
+  };
+  auto addPoint = [&](const glm::vec2 &point) {
+    const auto cell = cellOf(point);
+    grid[cell.y * gridSize.x + cell.x] = m_points.size();
+    active.push_back(m_points.size());
+    m_points.push_back(point);
+  };
+  addPoint(glm::vec2(distribution(generator), distribution(generator)) *
+           m_size);
+  const float minDistance2 = minDistance * minDistance;
+  while (!active.empty()) {
+    const int activeIndex = (int)(distribution(generator) * active.size()) %
+                            (int)active.size();
+    const auto origin = m_points[active[activeIndex]];
+    bool found = false;
+    for (int attempt = 0; attempt < m_attempts; attempt++) {
+      // Uniform in the annulus [r, 2r].
+      const float angle = distribution(generator) * 2.0f * glm::pi<float>();
+      const float radius =
+          minDistance * glm::sqrt(1.0f + 3.0f * distribution(generator));
+      const auto candidate =
+          origin + radius * glm::vec2(glm::cos(angle), glm::sin(angle));
+      if (candidate.x < 0.0f || candidate.y < 0.0f ||
+          candidate.x >= m_size.x || candidate.y >= m_size.y)
+        continue;
+      const auto cell = cellOf(candidate);
+      bool valid = true;
+      for (int z = glm::max(cell.y - 2, 0);
+           valid && z <= glm::min(cell.y + 2, gridSize.y - 1); z++) {
+        for (int x = glm::max(cell.x - 2, 0);
+             x <= glm::min(cell.x + 2, gridSize.x - 1); x++) {
+          const int neighbor = grid[z * gridSize.x + x];
+          if (neighbor != -1) {
+            const auto offset = m_points[neighbor] - candidate;
+            if (glm::dot(offset, offset) < minDistance2) {
+              valid = false;
+              break;
+            }
+          }
+        }
+      }
+      if (valid) {
+        addPoint(candidate);
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      active[activeIndex] = active.back();
+      active.pop_back();
+    }
+  }
+  const auto center = m_size / 2.0f;
+  for (auto &point : m_points)
+    point -= center;
+}
+void PoissonDiskSorghumField::GenerateMatrices() {
+  if (!m_sorghumStateGenerator.Get<SorghumStateGenerator>())
+    return;
+  GeneratePoints();
+  ClearPlants();
+  const int descriptorIndex = AddDescriptor(m_sorghumStateGenerator);
+  std::vector<glm::vec3> rotations(m_points.size());
+  for (auto &rotation : rotations)
+    rotation = glm::gaussRand(glm::vec3(0.0f), m_rotationVariance);
+  m_newSorghums.resize(m_points.size());
+  std::vector<std::shared_future<void>> results;
+  Jobs::ParallelFor(
+      m_points.size(),
+      [&](unsigned i) {
+        m_newSorghums[i].m_descriptorIndex = descriptorIndex;
+        m_newSorghums[i].m_seed = i;
+        m_newSorghums[i].m_transform =
+            glm::translate(glm::vec3(m_points[i].x, 0.0f, m_points[i].y)) *
+            glm::mat4_cast(glm::quat(glm::radians(rotations[i])));
+      },
+      results);
+  for (const auto &i : results)
+    i.wait();
+}
+void PoissonDiskSorghumField::OnInspect() {
+  SorghumField::OnInspect();
+  Editor::DragAndDropButton<SorghumStateGenerator>(m_sorghumStateGenerator,
+                                                   "SorghumStateGenerator");
+  ImGui::DragFloat2("Size", &m_size.x, 0.1f, 0.0f, 100000.0f);
+  ImGui::DragFloat("Min distance", &m_minDistance, 0.01f, 0.001f, 100.0f);
+  ImGui::DragInt("Attempts", &m_attempts, 1, 1, 100);
+  ImGui::DragInt("Seed", &m_seed);
+  ImGui::DragFloat3("Rotation variance", &m_rotationVariance.x, 0.01f, 0.0f,
+                    180.0f);
+  if (ImGui::Button("Generate points")) {
+    GeneratePoints();
+  }
+  ImGui::Text("Points: %d", (int)m_points.size());
+}
+void PoissonDiskSorghumField::Serialize(YAML::Emitter &out) {
+  m_sorghumStateGenerator.Save("m_sorghumStateGenerator", out);
+  out << YAML::Key << "m_size" << YAML::Value << m_size;
+  out << YAML::Key << "m_minDistance" << YAML::Value << m_minDistance;
+  out << YAML::Key << "m_attempts" << YAML::Value << m_attempts;
+  out << YAML::Key << "m_seed" << YAML::Value << m_seed;
+  out << YAML::Key << "m_rotationVariance" << YAML::Value << m_rotationVariance;
+  SaveListAsBinary<glm::vec2>("m_points", m_points, out);
+  SorghumField::Serialize(out);
+}
+void PoissonDiskSorghumField::Deserialize(const YAML::Node &in) {
+  m_sorghumStateGenerator.Load("m_sorghumStateGenerator", in);
+  if (in["m_size"])
+    m_size = in["m_size"].as<glm::vec2>();
+  if (in["m_minDistance"])
+    m_minDistance = in["m_minDistance"].as<float>();
+  if (in["m_attempts"])
+    m_attempts = in["m_attempts"].as<int>();
+  if (in["m_seed"])
+    m_seed = in["m_seed"].as<int>();
+  if (in["m_rotationVariance"])
+    m_rotationVariance = in["m_rotationVariance"].as<glm::vec3>();
+  LoadListFromBinary<glm::vec2>("m_points", m_points, in);
+  SorghumField::Deserialize(in);
+}
+void PoissonDiskSorghumField::CollectAssetRef(std::vector<AssetRef> &list) {
+  SorghumField::CollectAssetRef(list);
+  list.push_back(m_sorghumStateGenerator);
+}
@@ -3,16 +3,22 @@
 #include "RayTracerLayer.hpp"
 #include <TriangleIlluminationEstimator.hpp>
 #endif
+#include "CanopyRaster.hpp"
 #include "ClassRegistry.hpp"
 #include "DefaultResources.hpp"
 #include "FieldGround.hpp"
 #include "Graphics.hpp"
+#include "QuickHull.hpp"
 #include "LeafData.hpp"
 #include "PanicleData.hpp"
 #include "SkyIlluminance.hpp"
+#include "BinarySidecar.hpp"
+#include "SorghumMeshWriter.hpp"
 #include "StemData.hpp"
 #include <SorghumData.hpp>
 #include <SorghumLayer.hpp>
+#include <charconv>
+#include <optional>
 #ifdef RAYTRACERFACILITY
 #include "CBTFGroup.hpp"
 #include "DoubleCBTF.hpp"
@@ -22,6 +28,14 @@ using namespace RayTracerFacility;
 using namespace EcoSysLab;
 using namespace UniEngine;
 
+bool SorghumLayer::m_headless = false;
+
+void SorghumLayer::SetHeadless(bool value) { m_headless = value; }
+
+bool SorghumLayer::IsHeadless() { return m_headless; }
+
+void SorghumLayer::WaitForTextures() { m_textureLoader.Wait(); }
+
 void SorghumLayer::OnCreate() {
   ClassRegistry::RegisterDataComponent<PanicleTag>("PanicleTag");
   ClassRegistry::RegisterDataComponent<StemTag>("StemTag");
@@ -58,27 +72,31 @@ void SorghumLayer::OnCreate() {
       "RectangularSorghumField", {".rectsorghumfield"});
   ClassRegistry::RegisterAsset<PositionsField>("PositionsField",
                                                {".possorghumfield"});
-
-  auto texture2D = std::make_shared<Texture2D>();
-  texture2D->Import(std::filesystem::absolute(
-      std::filesystem::path("./SorghumFactoryResources/Textures") /
-      "ProceduralSorghum.png"));
-  Editor::AssetIcons()["ProceduralSorghum"] = texture2D;
-  texture2D = std::make_shared<Texture2D>();
-  texture2D->Import(std::filesystem::absolute(
-      std::filesystem::path("./SorghumFactoryResources/Textures") /
-      "SorghumStateGenerator.png"));
-  Editor::AssetIcons()["SorghumStateGenerator"] = texture2D;
-  texture2D = std::make_shared<Texture2D>();
-  texture2D->Import(std::filesystem::absolute(
-      std::filesystem::path("./SorghumFactoryResources/Textures") /
-      "PositionsField.png"));
-  Editor::AssetIcons()["PositionsField"] = texture2D;
-
-  texture2D->Import(std::filesystem::absolute(
-      std::filesystem::path("./SorghumFactoryResources/Textures") /
-      "GeneralDataPipeline.png"));
-  Editor::AssetIcons()["GeneralDataCapture"] = texture2D;
+  ClassRegistry::RegisterAsset<RowSorghumField>("RowSorghumField",
+                                                {".rowsorghumfield"});
+  ClassRegistry::RegisterAsset<PoissonDiskSorghumField>(
+      "PoissonDiskSorghumField", {".poissonsorghumfield"});
+  ClassRegistry::RegisterAsset<CanopyRaster>("CanopyRaster",
+                                             {".canopyraster"});
+
+  //Textures are decoded in the background, icons and materials pick them up once uploaded.
+  const auto textureFolder = std::filesystem::absolute(
+      std::filesystem::path("./SorghumFactoryResources/Textures"));
+  if (!m_headless) {
+    const std::pair<const char *, const char *> icons[] = {
+        {"ProceduralSorghum", "ProceduralSorghum.png"},
+        {"SorghumStateGenerator", "SorghumStateGenerator.png"},
+        {"PositionsField", "PositionsField.png"},
+        {"GeneralDataCapture", "GeneralDataPipeline.png"}};
+    for (const auto &[typeName, fileName] : icons) {
+      m_textureLoader.Load(
+          textureFolder / fileName, std::make_shared<Texture2D>(),
+          [typeName = std::string(typeName)](
+              const std::shared_ptr<Texture2D> &texture) {
+            Editor::AssetIcons()[typeName] = texture;
+          });
+    }
+  }
 
   m_leafArchetype = Entities::CreateEntityArchetype("Leaf", LeafTag());
   m_leafQuery = Entities::CreateEntityQuery();
@@ -116,19 +134,15 @@ void SorghumLayer::OnCreate() {
   m_stemGeometryQuery = Entities::CreateEntityQuery();
   m_stemGeometryQuery.SetAllFilters(StemGeometryTag());
 
-  if (!m_leafAlbedoTexture.Get<Texture2D>()) {
-    auto albedo = ProjectManager::CreateTemporaryAsset<Texture2D>();
-    albedo->Import(std::filesystem::absolute(
-        std::filesystem::path("./SorghumFactoryResources/Textures") /
-        "leafSurface.png"));
-    m_leafAlbedoTexture.Set(albedo);
-  }
+  const bool loadAlbedo = !m_leafAlbedoTexture.Get<Texture2D>();
 
   if (!m_leafMaterial.Get<Material>()) {
     auto material = ProjectManager::CreateTemporaryAsset<Material>();
     material->SetProgram(DefaultResources::GLPrograms::StandardProgram);
     m_leafMaterial = material;
-    material->m_albedoTexture = m_leafAlbedoTexture;
+    //The albedo color stands in until the texture is uploaded.
+    if (!loadAlbedo)
+      material->m_albedoTexture = m_leafAlbedoTexture;
     material->SetProgram(DefaultResources::GLPrograms::StandardProgram);
     material->m_drawSettings.m_cullFace = false;
     material->m_materialProperties.m_albedoColor =
@@ -137,6 +151,18 @@ void SorghumLayer::OnCreate() {
     material->m_materialProperties.m_metallic = 0.1f;
   }
 
+  if (loadAlbedo) {
+    m_textureLoader.Load(
+        textureFolder / "leafSurface.png",
+        ProjectManager::CreateTemporaryAsset<Texture2D>(),
+        [this](const std::shared_ptr<Texture2D> &texture) {
+          m_leafAlbedoTexture.Set(texture);
+          auto material = m_leafMaterial.Get<Material>();
+          if (material && !material->m_albedoTexture.Get<Texture2D>())
+            material->m_albedoTexture = m_leafAlbedoTexture;
+        });
+  }
+
   if (!m_leafBottomFaceMaterial.Get<Material>()) {
     auto material = ProjectManager::CreateTemporaryAsset<Material>();
     material->SetProgram(DefaultResources::GLPrograms::StandardProgram);
@@ -234,14 +260,130 @@ void SorghumLayer::GenerateMeshForAllSorghums() {
   scene->GetEntityArray(m_sorghumQuery, plants);
   for (auto &plant : plants) {
     if (scene->HasPrivateComponent<SorghumData>(plant)) {
-      auto sorghumData =
-          scene->GetOrSetPrivateComponent<SorghumData>(plant).lock();
-      sorghumData->FormPlant();
+      GenerateMeshForSorghum(plant);
+    }
+  }
+}
+
+void SorghumLayer::GenerateMeshForSorghum(const Entity &plant) {
+  auto scene = GetScene();
+  auto sorghumData =
+      scene->GetOrSetPrivateComponent<SorghumData>(plant).lock();
+  auto descriptor = sorghumData->m_descriptor.Get<IAsset>();
+  if (!m_enableImpostors || !descriptor || sorghumData->m_segmentedMask ||
+      glm::distance(scene->GetDataComponent<Transform>(plant).GetPosition(),
+                    m_impostorCenter) <= m_impostorDistance) {
+    sorghumData->FormPlant();
+    sorghumData->ApplyGeometry();
+    return;
+  }
+  unsigned version = 0;
+  float time = 1.0f;
+  if (auto proceduralSorghum = std::dynamic_pointer_cast<ProceduralSorghum>(descriptor)) {
+    version = proceduralSorghum->GetVersion();
+    time = sorghumData->m_currentTime;
+  } else if (auto sorghumStateGenerator = std::dynamic_pointer_cast<SorghumStateGenerator>(descriptor)) {
+    version = sorghumStateGenerator->GetVersion();
+  }
+  const auto handle = descriptor->GetHandle().GetValue();
+  const int timeBucket = (int)glm::round(
+      time / glm::max(m_impostorTimeStep, 0.001f));
+  const int variant = (int)((unsigned)sorghumData->m_seed %
+                            (unsigned)glm::max(m_impostorVariants, 1));
+  const std::tuple<uint64_t, int, int> key{handle, timeBucket, variant};
+  const auto found = m_impostors.find(key);
+  if (found != m_impostors.end() && found->second.m_version != version) {
+    // Proxies of older versions of this descriptor are never used again.
+    for (auto it = m_impostors.begin(); it != m_impostors.end();) {
+      if (std::get<0>(it->first) == handle && it->second.m_version != version)
+        it = m_impostors.erase(it);
+      else
+        ++it;
+    }
+  }
+  auto &record = m_impostors[key];
+  if (!record.m_mesh) {
+    // Bake the proxy from the first plant of this variant.
+    sorghumData->FormPlant();
+    std::vector<glm::vec3> points;
+    sorghumData->CollectPoints(points);
+    if (points.size() < 4) {
+      m_impostors.erase(key);
       sorghumData->ApplyGeometry();
+      return;
+    }
+    quickhull::QuickHull<float> quickHull;
+    auto hull = quickHull.getConvexHull(&points[0].x, points.size(), true, false);
+    const auto &hullVertices = hull.getVertexBuffer();
+    const auto &hullIndices = hull.getIndexBuffer();
+    std::vector<Vertex> vertices(hullIndices.size());
+    std::vector<glm::uvec3> triangles(hullIndices.size() / 3);
+    for (int i = 0; i < triangles.size(); i++) {
+      glm::vec3 corners[3];
+      for (int j = 0; j < 3; j++) {
+        const auto &v = hullVertices[hullIndices[i * 3 + j]];
+        corners[j] = glm::vec3(v.x, v.y, v.z);
+      }
+      const auto normal = glm::normalize(
+          glm::cross(corners[1] - corners[0], corners[2] - corners[0]));
+      for (int j = 0; j < 3; j++) {
+        vertices[i * 3 + j].m_position = corners[j];
+        vertices[i * 3 + j].m_normal = normal;
+      }
+      triangles[i] = glm::uvec3(i * 3, i * 3 + 1, i * 3 + 2);
+    }
+    record.m_version = version;
+    record.m_mesh = ProjectManager::CreateTemporaryAsset<Mesh>();
+    record.m_mesh->SetVertices(17, vertices, triangles);
+  }
+  sorghumData->m_recordedVersion = version;
+  sorghumData->ApplyImpostor(record.m_mesh);
+}
+
+void SorghumLayer::GeneratePendingSorghums(bool fullGeometry) {
+  std::vector<Entity> plants;
+  auto scene = GetScene();
+  scene->GetEntityArray(m_sorghumQuery, plants);
+  for (auto &plant : plants) {
+    if (scene->HasPrivateComponent<SorghumData>(plant)) {
+      scene->GetOrSetPrivateComponent<SorghumData>(plant)
+          .lock()
+          ->EnsureGeometry(fullGeometry);
     }
   }
 }
 
+void SorghumLayer::ReleaseLazySorghums() {
+  std::vector<Entity> plants;
+  auto scene = GetScene();
+  scene->GetEntityArray(m_sorghumQuery, plants);
+  for (auto &plant : plants) {
+    if (!scene->HasPrivateComponent<SorghumData>(plant))
+      continue;
+    auto sorghumData =
+        scene->GetOrSetPrivateComponent<SorghumData>(plant).lock();
+    if (sorghumData->m_lazyGeneration)
+      sorghumData->ReleaseGeometry();
+  }
+}
+
+bool SorghumLayer::SaveScene() {
+  ReleaseLazySorghums();
+  return GetScene()->Save();
+}
+
+void SorghumLayer::ClearImpostors() { m_impostors.clear(); }
+
+void SorghumLayer::UpdateFieldBVH() {
+  GeneratePendingSorghums();
+  auto scene = GetScene();
+  std::vector<Entity> plants;
+  scene->GetEntityArray(m_sorghumQuery, plants);
+  if (!m_fieldBVH.Empty() && m_fieldBVH.Refit(scene, plants))
+    return;
+  m_fieldBVH.Build(scene, plants);
+}
+
 void SorghumLayer::OnInspect() {
   auto scene = GetScene();
   if (ImGui::Begin("Sorghum")) {
@@ -268,10 +410,14 @@ void SorghumLayer::OnInspect() {
     Editor::DragAndDropButton<CBTFGroup>(m_leafCBTFGroup,
                                              "Leaf CBTFGroup");
 
-    ImGui::Checkbox("Enable BTF", &m_enableCompressedBTF);
+    //Plants only hold BTF renderers while it is enabled.
+    if (ImGui::Checkbox("Enable BTF", &m_enableCompressedBTF))
+      GenerateMeshForAllSorghums();
 #endif
     ImGui::Separator();
     ImGui::Checkbox("Auto regenerate sorghum", &m_autoRefreshSorghums);
+    ImGui::DragInt("Lazy generation per frame", &m_lazyGenerationBudget, 1, 1,
+                   1024);
     ImGui::Checkbox("Bottom Face", &m_enableBottomFace);
     if (ImGui::Button("Generate mesh for all sorghums")) {
       GenerateMeshForAllSorghums();
@@ -294,6 +440,37 @@ void SorghumLayer::OnInspect() {
     }
     ImGui::ColorEdit3("Skeleton color", &m_skeletonColor.x);
 
+    if (ImGui::TreeNodeEx("Impostors")) {
+      ImGui::Checkbox("Enable impostors", &m_enableImpostors);
+      ImGui::DragFloat("Impostor distance", &m_impostorDistance, 0.1f, 0.0f,
+                       1000.0f);
+      ImGui::DragFloat3("Impostor center", &m_impostorCenter.x, 0.1f);
+      //Cached proxies use the old buckets, they are dropped when these change.
+      if (ImGui::DragFloat("Time step", &m_impostorTimeStep, 0.01f, 0.001f,
+                           10.0f))
+        ClearImpostors();
+      if (ImGui::DragInt("Variants", &m_impostorVariants, 1, 1, 32))
+        ClearImpostors();
+      ImGui::Text("Baked impostors: %d", (int)m_impostors.size());
+      if (ImGui::Button("Clear impostors")) {
+        ClearImpostors();
+      }
+      ImGui::TreePop();
+    }
+    if (ImGui::TreeNodeEx("CPU BVH")) {
+      if (ImGui::Button("Update")) {
+        UpdateFieldBVH();
+      }
+      ImGui::SameLine();
+      if (ImGui::Button("Clear")) {
+        m_fieldBVH.Clear();
+      }
+      ImGui::DragInt("Max leaf size", &m_fieldBVH.m_maxLeafSize, 1, 1, 64);
+      ImGui::Text("Nodes: %d, triangles: %d", (int)m_fieldBVH.GetNodeAmount(),
+                  (int)m_fieldBVH.GetTriangleAmount());
+      ImGui::TreePop();
+    }
+
     if (Editor::DragAndDropButton<Texture2D>(m_leafAlbedoTexture,
                                              "Replace Leaf Albedo Texture")) {
       auto tex = m_leafAlbedoTexture.Get<Texture2D>();
@@ -338,6 +515,26 @@ void SorghumLayer::OnInspect() {
                         [this](const std::filesystem::path &path) {
                           ExportAllSorghumsModel(path.string());
                         });
+    FileUtils::SaveFile("Export PLY/GLB for all sorghums", "3D Model",
+                        {".ply", ".glb"},
+                        [this](const std::filesystem::path &path) {
+                          ExportAllSorghumsMesh(path);
+                        });
+    if (ImGui::Button("Save scene")) {
+      SaveScene();
+    }
+    FileUtils::SaveFile("Export scene with binary sidecar", "Scene",
+                        {".uescene"},
+                        [](const std::filesystem::path &path) {
+                          BinarySidecar::Export(Application::GetActiveScene(),
+                                                path);
+                        });
+    FileUtils::OpenFile("Import scene with binary sidecar", "Scene",
+                        {".uescene"},
+                        [](const std::filesystem::path &path) {
+                          BinarySidecar::Import(Application::GetActiveScene(),
+                                                path);
+                        });
 
     static bool opened = false;
 #ifdef RAYTRACERFACILITY
@@ -371,102 +568,186 @@ void SorghumLayer::OnInspect() {
   ImGui::End();
 }
 
-void SorghumLayer::ExportSorghum(const Entity &sorghum, std::ofstream &of,
+namespace ObjExport {
+//Same text as std::to_string, which formats with "%f".
+void AppendFloat(std::string &buffer, float value) {
+  char chars[64];
+  const auto result = std::to_chars(chars, chars + sizeof(chars), value,
+                                    std::chars_format::fixed, 6);
+  buffer.append(chars, result.ptr);
+}
+void AppendUnsigned(std::string &buffer, size_t value) {
+  char chars[24];
+  const auto result = std::to_chars(chars, chars + sizeof(chars), value);
+  buffer.append(chars, result.ptr);
+}
+bool HasGeometry(const std::shared_ptr<Mesh> &mesh) {
+  return mesh && !mesh->UnsafeGetTriangles().empty();
+}
+} // namespace ObjExport
+
+void SorghumLayer::CollectExportMeshes(
+    const std::shared_ptr<Scene> &scene, const Entity &sorghum,
+    std::vector<std::shared_ptr<Mesh>> &meshes) {
+  meshes.push_back(scene->GetOrSetPrivateComponent<MeshRenderer>(sorghum)
+                       .lock()
+                       ->m_mesh.Get<Mesh>());
+  scene->ForEachChild(sorghum, [&](Entity child) {
+    if (!scene->HasPrivateComponent<MeshRenderer>(child))
+      return;
+    meshes.push_back(scene->GetOrSetPrivateComponent<MeshRenderer>(child)
+                         .lock()
+                         ->m_mesh.Get<Mesh>());
+  });
+}
+
+void SorghumLayer::ExportSorghum(const glm::vec3 &position,
+                                 const std::vector<std::shared_ptr<Mesh>> &meshes,
+                                 std::string &buffer, unsigned &startIndex) {
+  buffer += "#Sorghum\n";
+  for (const auto &mesh : meshes) {
+    ObjExportHelper(position, mesh, buffer, startIndex);
+  }
+}
+
+void SorghumLayer::ExportSorghum(const Entity &sorghum, std::string &buffer,
                                  unsigned &startIndex) {
   auto scene = Application::GetActiveScene();
-  const std::string start = "#Sorghum\n";
-  of.write(start.c_str(), start.size());
-  of.flush();
   const auto position =
       scene->GetDataComponent<GlobalTransform>(sorghum).GetPosition();
+  std::vector<std::shared_ptr<Mesh>> meshes;
+  CollectExportMeshes(scene, sorghum, meshes);
+  ExportSorghum(position, meshes, buffer, startIndex);
+}
 
-  const auto stemMesh = scene->GetOrSetPrivateComponent<MeshRenderer>(sorghum)
-                            .lock()
-                            ->m_mesh.Get<Mesh>();
-  ObjExportHelper(position, stemMesh, of, startIndex);
-
-  scene->ForEachChild(sorghum, [&](Entity child) {
-    if (!scene->HasPrivateComponent<MeshRenderer>(child))
-      return;
-    const auto leafMesh = scene->GetOrSetPrivateComponent<MeshRenderer>(child)
-                              .lock()
-                              ->m_mesh.Get<Mesh>();
-    ObjExportHelper(position, leafMesh, of, startIndex);
-  });
+void SorghumLayer::ExportSorghum(const Entity &sorghum, std::ofstream &of,
+                                 unsigned &startIndex) {
+  std::string buffer;
+  ExportSorghum(sorghum, buffer, startIndex);
+  of.write(buffer.c_str(), buffer.size());
 }
 
 void SorghumLayer::ObjExportHelper(glm::vec3 position,
-                                   std::shared_ptr<Mesh> mesh,
-                                   std::ofstream &of, unsigned &startIndex) {
-  if (mesh && !mesh->UnsafeGetTriangles().empty()) {
-    std::string header =
-        "#Vertices: " + std::to_string(mesh->GetVerticesAmount()) +
-        ", tris: " + std::to_string(mesh->GetTriangleAmount());
-    header += "\n";
-    of.write(header.c_str(), header.size());
-    of.flush();
-    std::string o = "o ";
-    o += "[" + std::to_string(position.x) + "," + std::to_string(position.z) +
-         "]" + "\n";
-    of.write(o.c_str(), o.size());
-    of.flush();
-    std::string data;
+                                   const std::shared_ptr<Mesh> &mesh,
+                                   std::string &buffer, unsigned &startIndex) {
+  using namespace ObjExport;
+  if (!HasGeometry(mesh))
+    return;
+  const auto &vertices = mesh->UnsafeGetVertices();
+  const auto &triangles = mesh->UnsafeGetTriangles();
+  //Roughly the longest line per element, avoids regrowing the buffer mid mesh.
+  buffer.reserve(buffer.size() + vertices.size() * 160 +
+                 triangles.size() * 64 + 128);
+  buffer += "#Vertices: ";
+  AppendUnsigned(buffer, mesh->GetVerticesAmount());
+  buffer += ", tris: ";
+  AppendUnsigned(buffer, mesh->GetTriangleAmount());
+  buffer += "\no [";
+  AppendFloat(buffer, position.x);
+  buffer += ',';
+  AppendFloat(buffer, position.z);
+  buffer += "]\n";
 #pragma region Data collection
-
-    for (auto i = 0; i < mesh->UnsafeGetVertices().size(); i++) {
-      auto &vertexPosition = mesh->UnsafeGetVertices().at(i).m_position;
-      auto &color = mesh->UnsafeGetVertices().at(i).m_color;
-      data += "v " + std::to_string(vertexPosition.x + position.x) + " " +
-              std::to_string(vertexPosition.y + position.y) + " " +
-              std::to_string(vertexPosition.z + position.z) + " " +
-              std::to_string(color.x) + " " + std::to_string(color.y) + " " +
-              std::to_string(color.z) + "\n";
-    }
-    for (const auto &vertex : mesh->UnsafeGetVertices()) {
-      data += "vn " + std::to_string(vertex.m_normal.x) + " " +
-              std::to_string(vertex.m_normal.y) + " " +
-              std::to_string(vertex.m_normal.z) + "\n";
-    }
-
-    for (const auto &vertex : mesh->UnsafeGetVertices()) {
-      data += "vt " + std::to_string(vertex.m_texCoord.x) + " " +
-              std::to_string(vertex.m_texCoord.y) + "\n";
-    }
-    // data += "s off\n";
-    data += "# List of indices for faces vertices, with (x, y, z).\n";
-    auto &triangles = mesh->UnsafeGetTriangles();
-    for (auto i = 0; i < mesh->GetTriangleAmount(); i++) {
-      const auto triangle = triangles[i];
-      const auto f1 = triangle.x + startIndex;
-      const auto f2 = triangle.y + startIndex;
-      const auto f3 = triangle.z + startIndex;
-      data += "f " + std::to_string(f1) + "/" + std::to_string(f1) + "/" +
-              std::to_string(f1) + " " + std::to_string(f2) + "/" +
-              std::to_string(f2) + "/" + std::to_string(f2) + " " +
-              std::to_string(f3) + "/" + std::to_string(f3) + "/" +
-              std::to_string(f3) + "\n";
+  for (const auto &vertex : vertices) {
+    buffer += "v ";
+    AppendFloat(buffer, vertex.m_position.x + position.x);
+    buffer += ' ';
+    AppendFloat(buffer, vertex.m_position.y + position.y);
+    buffer += ' ';
+    AppendFloat(buffer, vertex.m_position.z + position.z);
+    buffer += ' ';
+    AppendFloat(buffer, vertex.m_color.x);
+    buffer += ' ';
+    AppendFloat(buffer, vertex.m_color.y);
+    buffer += ' ';
+    AppendFloat(buffer, vertex.m_color.z);
+    buffer += '\n';
+  }
+  for (const auto &vertex : vertices) {
+    buffer += "vn ";
+    AppendFloat(buffer, vertex.m_normal.x);
+    buffer += ' ';
+    AppendFloat(buffer, vertex.m_normal.y);
+    buffer += ' ';
+    AppendFloat(buffer, vertex.m_normal.z);
+    buffer += '\n';
+  }
+  for (const auto &vertex : vertices) {
+    buffer += "vt ";
+    AppendFloat(buffer, vertex.m_texCoord.x);
+    buffer += ' ';
+    AppendFloat(buffer, vertex.m_texCoord.y);
+    buffer += '\n';
+  }
+  buffer += "# List of indices for faces vertices, with (x, y, z).\n";
+  for (auto i = 0; i < mesh->GetTriangleAmount(); i++) {
+    const auto triangle = triangles[i];
+    const unsigned indices[3] = {triangle.x + startIndex,
+                                 triangle.y + startIndex,
+                                 triangle.z + startIndex};
+    buffer += 'f';
+    for (const auto index : indices) {
+      buffer += ' ';
+      AppendUnsigned(buffer, index);
+      buffer += '/';
+      AppendUnsigned(buffer, index);
+      buffer += '/';
+      AppendUnsigned(buffer, index);
     }
-    startIndex += mesh->GetVerticesAmount();
-#pragma endregion
-    of.write(data.c_str(), data.size());
-    of.flush();
+    buffer += '\n';
   }
+  startIndex += mesh->GetVerticesAmount();
+#pragma endregion
 }
 
 void SorghumLayer::ExportAllSorghumsModel(const std::string &filename) {
+  GeneratePendingSorghums(true);
   std::ofstream of;
   of.open(filename, std::ofstream::out | std::ofstream::trunc);
   if (of.is_open()) {
     std::string start = "#Sorghum field, by Bosheng Li";
     start += "\n";
     of.write(start.c_str(), start.size());
-    of.flush();
     auto scene = GetScene();
-    unsigned startIndex = 1;
     std::vector<Entity> sorghums;
     scene->GetEntityArray(m_sorghumQuery, sorghums);
-    for (const auto &plant : sorghums) {
-      ExportSorghum(plant, of, startIndex);
+    //Scene access stays on this thread, only the text formatting runs on workers.
+    const int plantAmount = sorghums.size();
+    std::vector<glm::vec3> positions(plantAmount);
+    std::vector<std::vector<std::shared_ptr<Mesh>>> meshes(plantAmount);
+    std::vector<unsigned> startIndices(plantAmount);
+    unsigned startIndex = 1;
+    for (int i = 0; i < plantAmount; i++) {
+      positions[i] =
+          scene->GetDataComponent<GlobalTransform>(sorghums[i]).GetPosition();
+      CollectExportMeshes(scene, sorghums[i], meshes[i]);
+      startIndices[i] = startIndex;
+      for (const auto &mesh : meshes[i]) {
+        if (ObjExport::HasGeometry(mesh))
+          startIndex += mesh->GetVerticesAmount();
+      }
+    }
+    //Plants are formatted in batches so the text of the whole field is never held at once.
+    const int batchSize = 256;
+    std::vector<std::string> buffers(glm::min(batchSize, plantAmount));
+    for (int batchStart = 0; batchStart < plantAmount; batchStart += batchSize) {
+      const int batchAmount = glm::min(batchSize, plantAmount - batchStart);
+      std::vector<std::shared_future<void>> results;
+      Jobs::ParallelFor(
+          batchAmount,
+          [&](unsigned i) {
+            auto &buffer = buffers[i];
+            buffer.clear();
+            unsigned plantStartIndex = startIndices[batchStart + i];
+            ExportSorghum(positions[batchStart + i], meshes[batchStart + i],
+                          buffer, plantStartIndex);
+          },
+          results);
+      for (auto &i : results)
+        i.wait();
+      for (int i = 0; i < batchAmount; i++) {
+        of.write(buffers[i].c_str(), buffers[i].size());
+      }
     }
     of.close();
     UNIENGINE_LOG("Sorghums saved as " + filename);
@@ -474,6 +755,27 @@ void SorghumLayer::ExportAllSorghumsModel(const std::string &filename) {
     UNIENGINE_ERROR("Can't open file!");
   }
 }
+void SorghumLayer::ExportAllSorghumsMesh(const std::filesystem::path &path) {
+  SorghumMeshFormat format;
+  if (!SorghumMeshWriter::GetFormat(path, format)) {
+    UNIENGINE_ERROR("Unsupported mesh format!");
+    return;
+  }
+  SorghumMeshWriter writer;
+  if (!writer.Open(path, format))
+    return;
+  GeneratePendingSorghums(true);
+  auto scene = GetScene();
+  std::vector<Entity> sorghums;
+  scene->GetEntityArray(m_sorghumQuery, sorghums);
+  SorghumPlantMesh plantMesh;
+  for (const auto &plant : sorghums) {
+    plantMesh.Collect(scene, plant);
+    writer.Write(plantMesh);
+  }
+  if (writer.Close())
+    UNIENGINE_LOG("Sorghums saved as " + path.string());
+}
 #ifdef RAYTRACERFACILITY
 void SorghumLayer::RenderLightProbes() {
   if (m_probeTransforms.empty() || m_probeColors.empty() ||
@@ -487,6 +789,7 @@ void SorghumLayer::RenderLightProbes() {
 
 #ifdef RAYTRACERFACILITY
 void SorghumLayer::CalculateIlluminationFrameByFrame() {
+  GeneratePendingSorghums();
   auto scene = GetScene();
   const auto *owners = scene->UnsafeGetPrivateComponentOwnersList<
       TriangleIlluminationEstimator>();
@@ -501,6 +804,7 @@ void SorghumLayer::CalculateIlluminationFrameByFrame() {
   m_processing = true;
 }
 void SorghumLayer::CalculateIllumination() {
+  GeneratePendingSorghums();
   auto scene = GetScene();
   const auto *owners = scene->UnsafeGetPrivateComponentOwnersList<
       TriangleIlluminationEstimator>();
@@ -537,6 +841,11 @@ void SorghumLayer::CalculateIllumination() {
 #endif
 void SorghumLayer::Update() {
   auto scene = GetScene();
+  //Nobody watches the placeholders in a headless run, the first frame waits instead.
+  if (m_headless)
+    m_textureLoader.Wait();
+  else
+    m_textureLoader.Update();
 #ifdef RAYTRACERFACILITY
   if (m_displayLightProbes) {
     RenderLightProbes();
@@ -603,30 +912,41 @@ Entity SorghumLayer::CreateSorghum(
 }
 
 void SorghumLayer::LateUpdate() {
-  if (m_autoRefreshSorghums) {
-    auto scene = GetScene();
-    std::vector<Entity> plants;
-    scene->GetEntityArray(m_sorghumQuery, plants);
-    for (auto &plant : plants) {
-      if (scene->HasPrivateComponent<SorghumData>(plant)) {
-        auto sorghumData =
-            scene->GetOrSetPrivateComponent<SorghumData>(plant).lock();
-        auto proceduralSorghum =
-            sorghumData->m_descriptor.Get<ProceduralSorghum>();
-        if (proceduralSorghum &&
-            proceduralSorghum->GetVersion() != sorghumData->m_recordedVersion) {
-          sorghumData->FormPlant();
-          sorghumData->ApplyGeometry();
-          continue;
-        }
-        auto sorghumStateGenerator =
-            sorghumData->m_descriptor.Get<SorghumStateGenerator>();
-        if (sorghumStateGenerator && sorghumStateGenerator->GetVersion() !=
-                                         sorghumData->m_recordedVersion) {
-          sorghumData->FormPlant();
-          sorghumData->ApplyGeometry();
-        }
+  auto scene = GetScene();
+  std::vector<Entity> plants;
+  scene->GetEntityArray(m_sorghumQuery, plants);
+  //Plants loaded without geometry are rebuilt a few at a time so loading a field doesn't stall.
+  int budget = m_lazyGenerationBudget;
+  //Descriptor versions resolved once per descriptor, fields share a handful of descriptors.
+  std::unordered_map<uint64_t, std::optional<unsigned>> versions;
+  for (auto &plant : plants) {
+    if (!scene->HasPrivateComponent<SorghumData>(plant))
+      continue;
+    auto sorghumData =
+        scene->GetOrSetPrivateComponent<SorghumData>(plant).lock();
+    if (sorghumData->IsGeometryPending()) {
+      if (budget > 0) {
+        sorghumData->EnsureGeometry();
+        budget--;
       }
+      continue;
+    }
+    if (!m_autoRefreshSorghums)
+      continue;
+    const auto handle = sorghumData->m_descriptor.GetAssetHandle().GetValue();
+    auto cached = versions.find(handle);
+    if (cached == versions.end()) {
+      std::optional<unsigned> version;
+      if (auto proceduralSorghum =
+              sorghumData->m_descriptor.Get<ProceduralSorghum>())
+        version = proceduralSorghum->GetVersion();
+      else if (auto sorghumStateGenerator =
+                   sorghumData->m_descriptor.Get<SorghumStateGenerator>())
+        version = sorghumStateGenerator->GetVersion();
+      cached = versions.emplace(handle, version).first;
+    }
+    if (cached->second && *cached->second != sorghumData->m_recordedVersion) {
+      GenerateMeshForSorghum(plant);
     }
   }
 }
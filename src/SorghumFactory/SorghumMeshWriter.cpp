@@ -0,0 +1,450 @@
+#include "SorghumMeshWriter.hpp"
+#include "LeafData.hpp"
+#include "PanicleData.hpp"
+#include "SorghumLayer.hpp"
+#include "StemData.hpp"
+#include <charconv>
+
+using namespace EcoSysLab;
+
+template <typename T> inline void AppendBinary(std::string &buffer, const T &value) {
+  buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+inline void AppendNumber(std::string &buffer, float value) {
+  char chars[32];
+  const auto result = std::to_chars(chars, chars + sizeof(chars), value);
+  buffer.append(chars, result.ptr);
+}
+
+inline void AppendNumber(std::string &buffer, size_t value) {
+  char chars[24];
+  const auto result = std::to_chars(chars, chars + sizeof(chars), value);
+  buffer.append(chars, result.ptr);
+}
+
+inline void AppendSeparator(std::string &list) {
+  if (!list.empty())
+    list += ',';
+}
+
+void SorghumPlantMesh::Collect(const std::shared_ptr<Scene> &scene,
+                               const Entity &sorghum) {
+  m_transform = scene->GetDataComponent<GlobalTransform>(sorghum).m_value;
+  m_organs.clear();
+  scene->ForEachChild(sorghum, [&](Entity child) {
+    SorghumOrganMesh organ;
+    if (scene->HasDataComponent<StemTag>(child)) {
+      auto stemData = scene->GetOrSetPrivateComponent<StemData>(child).lock();
+      organ.m_vertices = &stemData->m_vertices;
+      organ.m_triangles = &stemData->m_triangles;
+      organ.m_type = SorghumOrganType::Stem;
+    } else if (scene->HasDataComponent<LeafTag>(child)) {
+      auto leafData = scene->GetOrSetPrivateComponent<LeafData>(child).lock();
+      organ.m_vertices = &leafData->m_vertices;
+      organ.m_triangles = &leafData->m_triangles;
+      organ.m_type = SorghumOrganType::Leaf;
+      organ.m_leafIndex = leafData->m_index + 1;
+    } else if (scene->HasDataComponent<PanicleTag>(child)) {
+      auto panicleData =
+          scene->GetOrSetPrivateComponent<PanicleData>(child).lock();
+      organ.m_vertices = &panicleData->m_vertices;
+      organ.m_triangles = &panicleData->m_triangles;
+      organ.m_type = SorghumOrganType::Panicle;
+    } else {
+      return;
+    }
+    m_organs.push_back(organ);
+  });
+}
+
+void SorghumPlantMesh::MakeOwned() {
+  std::vector<std::vector<Vertex>> vertices(m_organs.size());
+  std::vector<std::vector<glm::uvec3>> triangles(m_organs.size());
+  for (int i = 0; i < m_organs.size(); i++) {
+    vertices[i] = *m_organs[i].m_vertices;
+    triangles[i] = *m_organs[i].m_triangles;
+  }
+  m_ownedVertices = std::move(vertices);
+  m_ownedTriangles = std::move(triangles);
+  for (int i = 0; i < m_organs.size(); i++) {
+    m_organs[i].m_vertices = &m_ownedVertices[i];
+    m_organs[i].m_triangles = &m_ownedTriangles[i];
+  }
+}
+
+bool SorghumMeshWriter::GetFormat(const std::filesystem::path &path,
+                                  SorghumMeshFormat &format) {
+  const auto extension = path.extension().string();
+  if (extension == ".ply") {
+    format = SorghumMeshFormat::Ply;
+    return true;
+  }
+  if (extension == ".glb") {
+    format = SorghumMeshFormat::Glb;
+    return true;
+  }
+  return false;
+}
+
+bool SorghumMeshWriter::Open(const std::filesystem::path &path,
+                             SorghumMeshFormat format) {
+  Close();
+  m_format = format;
+  m_path = path;
+  m_temporaryPath = path;
+  m_temporaryPath += ".tmp";
+  m_file.open(m_path, std::ofstream::out | std::ofstream::binary |
+                          std::ofstream::trunc);
+  m_temporary.open(m_temporaryPath, std::ofstream::out |
+                                        std::ofstream::binary |
+                                        std::ofstream::trunc);
+  if (!m_file.is_open() || !m_temporary.is_open()) {
+    UNIENGINE_ERROR("Can't open file!");
+    m_file.close();
+    m_temporary.close();
+    std::error_code errorCode;
+    std::filesystem::remove(m_temporaryPath, errorCode);
+    return false;
+  }
+  m_inMemory = false;
+  m_output = &m_file;
+  m_temporaryOutput = &m_temporary;
+  Begin();
+  return true;
+}
+
+bool SorghumMeshWriter::Open(SorghumMeshFormat format) {
+  Close();
+  m_format = format;
+  m_path.clear();
+  m_temporaryPath.clear();
+  m_memory.str(std::string());
+  m_memory.clear();
+  m_memoryTemporary.str(std::string());
+  m_memoryTemporary.clear();
+  m_data.clear();
+  m_inMemory = true;
+  m_output = &m_memory;
+  m_temporaryOutput = &m_memoryTemporary;
+  Begin();
+  return true;
+}
+
+void SorghumMeshWriter::Begin() {
+  m_plantAmount = 0;
+  m_vertexAmount = 0;
+  m_triangleAmount = 0;
+  m_nodes.clear();
+  m_meshes.clear();
+  m_accessors.clear();
+  m_bufferViews.clear();
+  m_binaryLength = 0;
+  m_meshAmount = 0;
+  m_accessorAmount = 0;
+  if (m_format == SorghumMeshFormat::Ply) {
+    // Counts are unknown until Close, they are patched in place.
+    const std::string placeholder = "0000000000";
+    std::string header = "ply\nformat binary_little_endian 1.0\n"
+                         "comment organ: 0 stem, 1 leaf, 2 panicle. "
+                         "leaf_index starts from 1, 0 for other organs\n"
+                         "element vertex ";
+    m_vertexCountOffset = header.size();
+    header += placeholder + "\n"
+                            "property float x\nproperty float y\nproperty float z\n"
+                            "property float nx\nproperty float ny\nproperty float nz\n"
+                            "property float u\nproperty float v\n"
+                            "property uchar red\nproperty uchar green\nproperty uchar blue\n"
+                            "property uchar organ\nproperty ushort leaf_index\n"
+                            "property uint plant_index\n"
+                            "element face ";
+    m_faceCountOffset = header.size();
+    header += placeholder + "\n"
+                            "property list uchar uint vertex_indices\n"
+                            "end_header\n";
+    m_output->write(header.data(), header.size());
+  }
+}
+
+bool SorghumMeshWriter::IsOpen() const { return m_output != nullptr; }
+
+void SorghumMeshWriter::AppendTemporary() {
+  if (m_inMemory) {
+    const auto data = m_memoryTemporary.str();
+    m_output->write(data.data(), data.size());
+    return;
+  }
+  m_temporary.close();
+  std::ifstream temporary(m_temporaryPath,
+                          std::ifstream::in | std::ifstream::binary);
+  m_file << temporary.rdbuf();
+}
+
+void SorghumMeshWriter::Write(const SorghumPlantMesh &plant) {
+  if (!IsOpen())
+    return;
+  if (m_format == SorghumMeshFormat::Ply)
+    WritePly(plant);
+  else
+    WriteGlb(plant);
+  m_plantAmount++;
+}
+
+void SorghumMeshWriter::WritePly(const SorghumPlantMesh &plant) {
+  const auto normalMatrix =
+      glm::transpose(glm::inverse(glm::mat3(plant.m_transform)));
+  // Vertices go straight to the output, faces to the temporary file.
+  m_buffer.clear();
+  for (const auto &organ : plant.m_organs) {
+    for (const auto &vertex : *organ.m_vertices) {
+      const glm::vec3 position =
+          plant.m_transform * glm::vec4(vertex.m_position, 1.0f);
+      glm::vec3 normal = normalMatrix * vertex.m_normal;
+      if (const float length = glm::length(normal); length > 0.0f)
+        normal /= length;
+      AppendBinary(m_buffer, position);
+      AppendBinary(m_buffer, normal);
+      AppendBinary(m_buffer, vertex.m_texCoord);
+      const auto color =
+          glm::round(glm::clamp(glm::vec3(vertex.m_color), 0.0f, 1.0f) * 255.0f);
+      for (int i = 0; i < 3; i++)
+        AppendBinary(m_buffer, static_cast<unsigned char>(color[i]));
+      AppendBinary(m_buffer, static_cast<unsigned char>(organ.m_type));
+      AppendBinary(m_buffer, organ.m_leafIndex);
+      AppendBinary(m_buffer, m_plantAmount);
+    }
+  }
+  m_output->write(m_buffer.data(), m_buffer.size());
+
+  m_buffer.clear();
+  auto vertexOffset = static_cast<unsigned>(m_vertexAmount);
+  for (const auto &organ : plant.m_organs) {
+    for (const auto &triangle : *organ.m_triangles) {
+      AppendBinary(m_buffer, static_cast<unsigned char>(3));
+      AppendBinary(m_buffer, triangle + vertexOffset);
+    }
+    vertexOffset += organ.m_vertices->size();
+    m_triangleAmount += organ.m_triangles->size();
+  }
+  m_vertexAmount = vertexOffset;
+  m_temporaryOutput->write(m_buffer.data(), m_buffer.size());
+}
+
+void SorghumMeshWriter::AddBufferView(size_t byteLength, int target) {
+  AppendSeparator(m_bufferViews);
+  m_bufferViews += "{\"buffer\":0,\"byteOffset\":";
+  AppendNumber(m_bufferViews, m_binaryLength);
+  m_bufferViews += ",\"byteLength\":";
+  AppendNumber(m_bufferViews, byteLength);
+  m_bufferViews += ",\"target\":";
+  AppendNumber(m_bufferViews, (size_t)target);
+  m_bufferViews += '}';
+  m_binaryLength += byteLength;
+}
+
+void SorghumMeshWriter::WriteGlb(const SorghumPlantMesh &plant) {
+  size_t vertexAmount = 0;
+  size_t triangleAmount = 0;
+  for (const auto &organ : plant.m_organs) {
+    vertexAmount += organ.m_vertices->size();
+    triangleAmount += organ.m_triangles->size();
+  }
+  AppendSeparator(m_nodes);
+  m_nodes += "{\"name\":\"Plant ";
+  AppendNumber(m_nodes, (size_t)m_plantAmount);
+  m_nodes += "\",\"matrix\":[";
+  const float *matrix = &plant.m_transform[0][0];
+  for (int i = 0; i < 16; i++) {
+    if (i != 0)
+      m_nodes += ',';
+    AppendNumber(m_nodes, matrix[i]);
+  }
+  m_nodes += ']';
+  if (vertexAmount == 0 || triangleAmount == 0) {
+    m_nodes += '}';
+    return;
+  }
+  m_nodes += ",\"mesh\":";
+  AppendNumber(m_nodes, (size_t)m_meshAmount);
+  m_nodes += '}';
+
+  // Every element is a multiple of 4 bytes, so all views stay 4 byte aligned.
+  // Positions, normals, texture coordinates, labels and indices, one block each.
+  glm::vec3 min = glm::vec3(FLT_MAX);
+  glm::vec3 max = glm::vec3(-FLT_MAX);
+  m_buffer.clear();
+  for (const auto &organ : plant.m_organs) {
+    for (const auto &vertex : *organ.m_vertices) {
+      AppendBinary(m_buffer, vertex.m_position);
+      min = glm::min(min, vertex.m_position);
+      max = glm::max(max, vertex.m_position);
+    }
+  }
+  AddBufferView(vertexAmount * sizeof(glm::vec3), 34962);
+  for (const auto &organ : plant.m_organs) {
+    for (const auto &vertex : *organ.m_vertices)
+      AppendBinary(m_buffer, vertex.m_normal);
+  }
+  AddBufferView(vertexAmount * sizeof(glm::vec3), 34962);
+  for (const auto &organ : plant.m_organs) {
+    for (const auto &vertex : *organ.m_vertices)
+      AppendBinary(m_buffer, vertex.m_texCoord);
+  }
+  AddBufferView(vertexAmount * sizeof(glm::vec2), 34962);
+  for (const auto &organ : plant.m_organs) {
+    const unsigned short label[2] = {(unsigned short)organ.m_type,
+                                     organ.m_leafIndex};
+    for (size_t i = 0; i < organ.m_vertices->size(); i++)
+      AppendBinary(m_buffer, label);
+  }
+  AddBufferView(vertexAmount * sizeof(unsigned short) * 2, 34962);
+  unsigned vertexOffset = 0;
+  for (const auto &organ : plant.m_organs) {
+    for (const auto &triangle : *organ.m_triangles)
+      AppendBinary(m_buffer, triangle + vertexOffset);
+    vertexOffset += organ.m_vertices->size();
+  }
+  AddBufferView(triangleAmount * sizeof(glm::uvec3), 34963);
+  m_temporaryOutput->write(m_buffer.data(), m_buffer.size());
+
+  const auto addAccessor = [&](int componentType, const char *type,
+                               size_t count, const std::string &extra) {
+    AppendSeparator(m_accessors);
+    m_accessors += "{\"bufferView\":";
+    AppendNumber(m_accessors, (size_t)m_accessorAmount);
+    m_accessors += ",\"componentType\":";
+    AppendNumber(m_accessors, (size_t)componentType);
+    m_accessors += ",\"count\":";
+    AppendNumber(m_accessors, count);
+    m_accessors += ",\"type\":\"";
+    m_accessors += type;
+    m_accessors += '"';
+    m_accessors += extra;
+    m_accessors += '}';
+    return m_accessorAmount++;
+  };
+  std::string bounds = ",\"min\":[";
+  for (int i = 0; i < 3; i++) {
+    if (i != 0)
+      bounds += ',';
+    AppendNumber(bounds, min[i]);
+  }
+  bounds += "],\"max\":[";
+  for (int i = 0; i < 3; i++) {
+    if (i != 0)
+      bounds += ',';
+    AppendNumber(bounds, max[i]);
+  }
+  bounds += ']';
+  const auto position = addAccessor(5126, "VEC3", vertexAmount, bounds);
+  const auto normal = addAccessor(5126, "VEC3", vertexAmount, "");
+  const auto texCoord = addAccessor(5126, "VEC2", vertexAmount, "");
+  const auto label = addAccessor(5123, "VEC2", vertexAmount, "");
+  const auto indices = addAccessor(5125, "SCALAR", triangleAmount * 3, "");
+
+  // _LABEL holds organ type and leaf index.
+  AppendSeparator(m_meshes);
+  m_meshes += "{\"primitives\":[{\"attributes\":{\"POSITION\":";
+  AppendNumber(m_meshes, (size_t)position);
+  m_meshes += ",\"NORMAL\":";
+  AppendNumber(m_meshes, (size_t)normal);
+  m_meshes += ",\"TEXCOORD_0\":";
+  AppendNumber(m_meshes, (size_t)texCoord);
+  m_meshes += ",\"_LABEL\":";
+  AppendNumber(m_meshes, (size_t)label);
+  m_meshes += "},\"indices\":";
+  AppendNumber(m_meshes, (size_t)indices);
+  m_meshes += ",\"mode\":4}]}";
+  m_meshAmount++;
+  m_vertexAmount += vertexAmount;
+  m_triangleAmount += triangleAmount;
+}
+
+bool SorghumMeshWriter::ClosePly() {
+  const auto patch = [&](std::streamoff offset, size_t count) {
+    char chars[11] = "0000000000";
+    const auto digits = std::to_string(count);
+    if (digits.size() > 10)
+      return false;
+    std::copy(digits.begin(), digits.end(), chars + 10 - digits.size());
+    m_output->seekp(offset);
+    m_output->write(chars, 10);
+    return true;
+  };
+  if (m_triangleAmount > 0)
+    AppendTemporary();
+  return patch(m_vertexCountOffset, m_vertexAmount) &&
+         patch(m_faceCountOffset, m_triangleAmount);
+}
+
+bool SorghumMeshWriter::CloseGlb() {
+  std::string json =
+      "{\"asset\":{\"version\":\"2.0\",\"generator\":\"SorghumFactory\"},"
+      "\"scene\":0,\"scenes\":[{\"nodes\":[";
+  for (unsigned i = 0; i < m_plantAmount; i++) {
+    if (i != 0)
+      json += ',';
+    AppendNumber(json, (size_t)i);
+  }
+  json += "]}],\"nodes\":[" + m_nodes + "]";
+  if (m_binaryLength > 0) {
+    json += ",\"meshes\":[" + m_meshes + "],\"accessors\":[" + m_accessors +
+            "],\"bufferViews\":[" + m_bufferViews +
+            "],\"buffers\":[{\"byteLength\":";
+    AppendNumber(json, m_binaryLength);
+    json += "}]";
+  }
+  json += '}';
+  while (json.size() % 4 != 0)
+    json += ' ';
+
+  const auto jsonLength = static_cast<uint32_t>(json.size());
+  const auto binaryLength = static_cast<uint32_t>(m_binaryLength);
+  const uint32_t totalLength =
+      12 + 8 + jsonLength + (binaryLength > 0 ? 8 + binaryLength : 0);
+  const uint32_t header[5] = {0x46546C67, 2, totalLength, jsonLength,
+                              0x4E4F534A};
+  m_output->write(reinterpret_cast<const char *>(header), sizeof(header));
+  m_output->write(json.data(), json.size());
+  if (binaryLength > 0) {
+    const uint32_t binaryHeader[2] = {binaryLength, 0x004E4942};
+    m_output->write(reinterpret_cast<const char *>(binaryHeader),
+                    sizeof(binaryHeader));
+    AppendTemporary();
+  }
+  return true;
+}
+
+bool SorghumMeshWriter::Close() {
+  if (!m_output) {
+    if (m_temporary.is_open())
+      m_temporary.close();
+    return false;
+  }
+  bool succeed =
+      m_format == SorghumMeshFormat::Ply ? ClosePly() : CloseGlb();
+  succeed = succeed && m_output->good();
+  m_output = nullptr;
+  m_temporaryOutput = nullptr;
+  if (m_inMemory) {
+    m_data = m_memory.str();
+    m_memory.str(std::string());
+    m_memoryTemporary.str(std::string());
+  } else {
+    if (m_temporary.is_open())
+      m_temporary.close();
+    m_file.close();
+    std::error_code errorCode;
+    std::filesystem::remove(m_temporaryPath, errorCode);
+  }
+  m_buffer.clear();
+  m_buffer.shrink_to_fit();
+  if (!succeed)
+    UNIENGINE_ERROR("Failed to finish " +
+                    (m_inMemory ? std::string("mesh") : m_path.string()));
+  return succeed;
+}
+
+std::string SorghumMeshWriter::TakeData() { return std::move(m_data); }
+
+SorghumMeshWriter::~SorghumMeshWriter() { Close(); }
@@ -1,4 +1,5 @@
 #include "ProjectManager.hpp"
+#include "SorghumBatchExporter.hpp"
 #include "SorghumLayer.hpp"
 #include <SorghumStateGenerator.hpp>
 #include <rapidxml.hpp>
@@ -20,6 +21,12 @@ void SorghumStateGenerator::OnInspect() {
         std::dynamic_pointer_cast<SorghumStateGenerator>(m_self.lock()));
     Application::GetActiveScene()->SetEntityName(sorghum, m_self.lock()->GetAssetRecord().lock()->GetAssetFileName());
   }
+  if (ImGui::TreeNode("Batch mesh export")) {
+    static SorghumBatchExporter batchExporter;
+    batchExporter.OnInspect(
+        std::dynamic_pointer_cast<SorghumStateGenerator>(m_self.lock()));
+    ImGui::TreePop();
+  }
   static bool autoSave = true;
   ImGui::Checkbox("Auto save", &autoSave);
   static bool intro = true;
@@ -3,6 +3,7 @@
 //
 
 #include "StemData.hpp"
+#include "BinarySidecar.hpp"
 #include "DefaultResources.hpp"
 #include "Graphics.hpp"
 #include "SorghumLayer.hpp"
@@ -50,6 +51,9 @@ void StemData::OnDestroy() {
 }
 void StemData::Serialize(YAML::Emitter &out) {
   out << YAML::Key << "m_left" << YAML::Value << m_left;
+  //Rebuilt from the plant on load.
+  if (SorghumData::IsLazyOrgan(GetScene(), GetOwner()))
+    return;
   out << YAML::Key << "m_curves" << YAML::BeginSeq;
   for (const auto &i : m_curves) {
     out << YAML::BeginMap;
@@ -61,11 +65,7 @@ void StemData::Serialize(YAML::Emitter &out) {
   }
   out << YAML::EndSeq;
 
-  if (!m_nodes.empty()) {
-    out << YAML::Key << "m_nodes" << YAML::Value
-        << YAML::Binary((const unsigned char *)m_nodes.data(),
-                        m_nodes.size() * sizeof(SplineNode));
-  }
+  SaveListAsBinary<SplineNode>("m_nodes", m_nodes, out);
 }
 void EcoSysLab::StemData::Deserialize(const YAML::Node &in) {
 
@@ -79,11 +79,7 @@ void EcoSysLab::StemData::Deserialize(const YAML::Node &in) {
     }
   }
 
-  if (in["m_nodes"]) {
-    YAML::Binary nodes = in["m_nodes"].as<YAML::Binary>();
-    m_nodes.resize(nodes.size() / sizeof(SplineNode));
-    std::memcpy(m_nodes.data(), nodes.data(), nodes.size());
-  }
+  LoadListFromBinary<SplineNode>("m_nodes", m_nodes, in);
 }
 void StemData::GenerateStemGeometry() {
   auto sorghumLayer = Application::GetLayer<SorghumLayer>();
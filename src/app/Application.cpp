@@ -24,7 +24,11 @@ using namespace EcoSysLab;
 using namespace RayTracerFacility;
 #endif
 
-int main() {
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (std::string(argv[i]) == "--headless")
+      SorghumLayer::SetHeadless(true);
+  }
   ClassRegistry::RegisterPrivateComponent<AutoSorghumGenerationPipeline>(
       "AutoSorghumGenerationPipeline");
 #ifdef RAYTRACERFACILITY